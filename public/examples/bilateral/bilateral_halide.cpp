@@ -0,0 +1,236 @@
+// Generator.cpp
+#include <Halide.h>
+using namespace Halide;
+
+// The Halide baseline for the DSL's bilateral_filter(spatial_sigma, range_sigma), computed
+// on a bilateral grid (Chen, Paris and Durand 2007): each channel is splatted into a
+// coarse (x, y, intensity) grid with one cell per spatial sigma and one bin per range
+// sigma, the grid is blurred with a [1 4 6 4 1] kernel along all three axes, and every
+// pixel reads its result back by trilinear interpolation. Both sigmas are run-time inputs
+// and the work per pixel does not grow with them; a larger sigma only shrinks the grid.
+class BilateralGridGenerator : public Halide::Generator<BilateralGridGenerator> {
+public:
+    // Frame size the autoscheduler tunes for; build-halide.sh builds one per size class
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
+    Input<Buffer<uint8_t>> input{"input", 3};
+    Input<float> spatial_sigma{"spatial_sigma", 3.0f};  // pixels, rounded to the grid cell
+    Input<float> range_sigma{"range_sigma", 10.0f};     // 8-bit levels
+    Output<Buffer<uint8_t>> output{"output", 3};
+
+    void generate() {
+        Var x("x"), y("y"), z("z"), c("c"), k("k");
+
+        Func input_bounded("input_bounded");
+        input_bounded = BoundaryConditions::repeat_edge(input);
+
+        Func input_float("input_float");
+        input_float(x, y, c) = cast<float>(input_bounded(x, y, c)) / 255.0f;
+
+        Expr cell = max(cast<int>(spatial_sigma + 0.5f), 1);
+        Expr bins_per_unit = 255.0f / range_sigma;
+
+        // Splat: grid node (x, y) gathers the cell centred on pixel (x, y) * cell. k = 0
+        // sums the values that fall in each intensity bin, k = 1 counts them.
+        Func histogram("histogram");
+        RDom r(0, cell, 0, cell, "r");
+        Expr splat = input_float(x * cell + r.x - cell / 2, y * cell + r.y - cell / 2, c);
+        Expr bin = cast<int>(splat * bins_per_unit + 0.5f);
+        histogram(x, y, z, c, k) = 0.0f;
+        histogram(x, y, bin, c, k) += mux(k, {splat, 1.0f});
+
+        // Blur the grid, which is a Gaussian of one cell and one bin
+        Func blur_z("blur_z"), blur_x("blur_x"), blur_y("blur_y");
+        blur_z(x, y, z, c, k) = histogram(x, y, z - 2, c, k) + 4 * histogram(x, y, z - 1, c, k) +
+                                6 * histogram(x, y, z, c, k) +
+                                4 * histogram(x, y, z + 1, c, k) + histogram(x, y, z + 2, c, k);
+        blur_x(x, y, z, c, k) = blur_z(x - 2, y, z, c, k) + 4 * blur_z(x - 1, y, z, c, k) +
+                                6 * blur_z(x, y, z, c, k) +
+                                4 * blur_z(x + 1, y, z, c, k) + blur_z(x + 2, y, z, c, k);
+        blur_y(x, y, z, c, k) = blur_x(x, y - 2, z, c, k) + 4 * blur_x(x, y - 1, z, c, k) +
+                                6 * blur_x(x, y, z, c, k) +
+                                4 * blur_x(x, y + 1, z, c, k) + blur_x(x, y + 2, z, c, k);
+
+        // Slice: trilinear lookup at the pixel's position and intensity
+        Expr value = input_float(x, y, c);
+        Expr zv = value * bins_per_unit;
+        Expr gz = cast<int>(zv);
+        Expr zf = zv - gz;
+        Expr gx = x / cell, gy = y / cell;
+        Expr xf = cast<float>(x % cell) / cell;
+        Expr yf = cast<float>(y % cell) / cell;
+        auto bilinear = [&](Expr iz) {
+            return lerp(lerp(blur_y(gx, gy, iz, c, k), blur_y(gx + 1, gy, iz, c, k), xf),
+                        lerp(blur_y(gx, gy + 1, iz, c, k), blur_y(gx + 1, gy + 1, iz, c, k), xf), yf);
+        };
+        Func interpolated("interpolated");
+        interpolated(x, y, c, k) = lerp(bilinear(gz), bilinear(gz + 1), zf);
+
+        // Normalize the value sum by the weight and convert back to uint8
+        Expr filtered = interpolated(x, y, c, 0) / interpolated(x, y, c, 1);
+        output(x, y, c) = cast<uint8_t>(clamp(filtered * 255.0f + 0.5f, 0.0f, 255.0f));
+
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(3);
+        output.dim(2).set_stride(1).set_bounds(0, 3);
+
+        // Set estimates for autoscheduler
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        spatial_sigma.set_estimate(3.0f);
+        range_sigma.set_estimate(10.0f);
+
+        if (!using_autoscheduler()) {
+            // Hand-written schedule (the "manual" variant): parallel strips of eight grid
+            // rows, each splatting and blurring only the part of the grid it reads (plus a
+            // few halo rows), so the grid stays small and cache-resident at any sigma
+            Var yo("yo"), yi("yi");
+            const int vec = natural_vector_size<float>();
+            output.reorder(c, x, y).bound(c, 0, 3).unroll(c)
+                  .split(y, yo, yi, 8 * cell, TailStrategy::GuardWithIf).parallel(yo);
+            output.vectorize(x, vec);
+
+            histogram.compute_at(output, yo).vectorize(x, vec);
+            histogram.update().reorder(k, c, r.x, r.y, x, y).unroll(k).unroll(c);
+            blur_z.compute_at(output, yo).vectorize(x, vec);
+            blur_x.compute_at(output, yo).vectorize(x, vec);
+            blur_y.compute_at(output, yo).vectorize(x, vec);
+        }
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(BilateralGridGenerator, bilateral_grid)
+
+// Runner.cpp
+#include <Halide.h>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../../../runtime/stb_image_write.h"
+
+#include "bilateral_grid_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc < 3 || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [spatial_sigma] [range_sigma] [options]\n";
+        std::cerr << "Defaults: spatial_sigma=3 (pixels), range_sigma=10 (8-bit levels)\n";
+        print_runner_flags(std::cerr);
+        return 1;
+    }
+
+    // Sigmas are pipeline inputs, so any values run without regenerating
+    float spatial_sigma = argc >= 4 ? std::stof(argv[3]) : 3.0f;
+    float range_sigma = argc >= 5 ? std::stof(argv[4]) : 10.0f;
+    if (spatial_sigma <= 0 || range_sigma <= 0) {
+        std::cerr << "Sigmas must be positive\n";
+        return 1;
+    }
+
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
+        return 1;
+    }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
+
+    if (options.batch) {
+        return run_batch(options, "bilateral_grid", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return bilateral_grid(input.raw_buffer(), spatial_sigma, range_sigma, output.raw_buffer());
+        });
+    }
+
+    if (options.stream) {
+        // A pixel reads grid rows down to 3.5 cells above it and up to 4 cells below
+        const int cell = std::max((int)(spatial_sigma + 0.5f), 1);
+        return run_stream(options, "bilateral_grid", argv[1], argv[2], 4 * cell, [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return bilateral_grid(input.raw_buffer(), spatial_sigma, range_sigma, output.raw_buffer());
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "bilateral_grid", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return bilateral_grid(input.raw_buffer(), spatial_sigma, range_sigma, output.raw_buffer());
+        });
+    }
+
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
+        std::cerr << "Failed to load input image: " << argv[1] << "\n";
+        return 1;
+    }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
+
+    std::cout << "Loaded image: " << width << "x" << height
+              << " (" << channels << " channels)\n";
+
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
+
+    // Interleaved output doubles as the encoder input
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, 3);
+
+    std::cout << "Processing image with the bilateral grid (spatial_sigma=" << spatial_sigma
+              << ", range_sigma=" << range_sigma << ")...\n";
+
+    int result = run_benchmark(options, stats, [&] {
+        return bilateral_grid(input.raw_buffer(), spatial_sigma, range_sigma, output.raw_buffer());
+    });
+    if (result != 0) {
+        std::cerr << "Error in bilateral filter\n";
+        return 1;
+    }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "bilateral_grid")) {
+        return 1;
+    }
+
+    // Optional check against a reference image (a golden or another schedule's output)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
+
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
+
+    if (!success) {
+        std::cerr << "Failed to save output image\n";
+        return 1;
+    }
+
+    std::cout << "Saved output: " << argv[2] << "\n";
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "bilateral_grid", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
+}
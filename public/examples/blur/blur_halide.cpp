@@ -3,8 +3,17 @@
 
 using namespace Halide;
 
+// [1 2 1] / 4 across three neighbours
+static Expr taps_121(Expr a, Expr b, Expr c) {
+    return (a + 2.0f * b + c) * 0.25f;
+}
+
 class Gaussian3x3AutoGenerator : public Halide::Generator<Gaussian3x3AutoGenerator> {
 public:
+    // Frame size the autoscheduler tunes for (build-halide.sh builds one per size class)
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
     Input<Buffer<uint8_t>> input{"input", 3};
     Output<Buffer<uint8_t>> output{"output", 3};
 
@@ -21,25 +30,94 @@ public:
         // Define the 3x3 Gaussian kernel (normalized)
         // Using approximation: [1 2 1; 2 4 2; 1 2 1] / 16
         Func blur_x("blur_x");
-        blur_x(x, y, c) = (input_float(x-1, y, c) + 
-                          2.0f * input_float(x, y, c) + 
-                          input_float(x+1, y, c)) * 0.25f;
+        blur_x(x, y, c) = taps_121(input_float(x-1, y, c), input_float(x, y, c), input_float(x+1, y, c));
 
         Func blur_y("blur_y");
-        blur_y(x, y, c) = (blur_x(x, y-1, c) + 
-                          2.0f * blur_x(x, y, c) + 
-                          blur_x(x, y+1, c)) * 0.25f;
+        blur_y(x, y, c) = taps_121(blur_x(x, y-1, c), blur_x(x, y, c), blur_x(x, y+1, c));
 
         // Convert back to uint8
         output(x, y, c) = cast<uint8_t>(clamp(blur_y(x, y, c) * 255.0f, 0.0f, 255.0f));
 
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(3);
+        output.dim(2).set_stride(1).set_bounds(0, 3);
+
         // Set estimates for autoscheduler
-        input.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
-        output.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+
+        if (!using_autoscheduler()) {
+            // Hand-written schedule (the "manual" variant): parallel strips of rows; the
+            // horizontal pass slides down each strip one row ahead of the vertical pass
+            Var yo("yo"), yi("yi");
+            const int vec = natural_vector_size<float>();
+            output.reorder(c, x, y).bound(c, 0, 3).unroll(c)
+                  .split(y, yo, yi, 32, TailStrategy::GuardWithIf).parallel(yo);
+            // Rows that are a whole number of vectors skip the shifted last vector
+            output.specialize(output.dim(0).extent() % vec == 0).vectorize(x, vec, TailStrategy::RoundUp);
+            output.vectorize(x, vec);
+            blur_x.store_at(output, yo).compute_at(output, yi)
+                  .reorder(c, x, y).unroll(c).vectorize(x, vec);
+        }
+    }
+};
+
+// The same blur over a batch of equally sized images (x, y, c, n) in one call, for
+// thumbnail workloads where a call per image is dominated by call and fork/join
+// overhead. Runners pack the images with --batch --pack.
+class Gaussian3x3BatchGenerator : public Halide::Generator<Gaussian3x3BatchGenerator> {
+public:
+    GeneratorParam<int> estimate_width{"estimate_width", 256};
+    GeneratorParam<int> estimate_height{"estimate_height", 256};
+    GeneratorParam<int> estimate_batch{"estimate_batch", 64};
+
+    Input<Buffer<uint8_t>> input{"input", 4};
+    Output<Buffer<uint8_t>> output{"output", 4};
+
+    void generate() {
+        Var x("x"), y("y"), c("c"), n("n");
+
+        // Edges repeat within each image
+        Func input_bounded("input_bounded");
+        input_bounded = BoundaryConditions::repeat_edge(input);
+
+        Func input_float("input_float");
+        input_float(x, y, c, n) = cast<float>(input_bounded(x, y, c, n)) / 255.0f;
+
+        Func blur_x("blur_x");
+        blur_x(x, y, c, n) = taps_121(input_float(x-1, y, c, n), input_float(x, y, c, n), input_float(x+1, y, c, n));
+
+        Func blur_y("blur_y");
+        blur_y(x, y, c, n) = taps_121(blur_x(x, y-1, c, n), blur_x(x, y, c, n), blur_x(x, y+1, c, n));
+
+        output(x, y, c, n) = cast<uint8_t>(clamp(blur_y(x, y, c, n) * 255.0f, 0.0f, 255.0f));
+
+        // Each image interleaved as in the single-image generator, images one after another
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(3);
+        output.dim(2).set_stride(1).set_bounds(0, 3);
+
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}, {0, estimate_batch}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}, {0, estimate_batch}});
+
+        if (!using_autoscheduler()) {
+            // One image per parallel task, the horizontal pass sliding down the image one
+            // row ahead of the vertical pass
+            const int vec = natural_vector_size<float>();
+            output.reorder(c, x, y, n).bound(c, 0, 3).unroll(c).parallel(n);
+            output.specialize(output.dim(0).extent() % vec == 0).vectorize(x, vec, TailStrategy::RoundUp);
+            output.vectorize(x, vec);
+            blur_x.store_at(output, n).compute_at(output, y)
+                  .reorder(c, x, y).unroll(c).vectorize(x, vec);
+        }
     }
 };
 
 HALIDE_REGISTER_GENERATOR(Gaussian3x3AutoGenerator, gaussian3x3_auto)
+HALIDE_REGISTER_GENERATOR(Gaussian3x3BatchGenerator, gaussian3x3_batch)
 
 // Runner.cpp
 #include <Halide.h>
@@ -49,76 +127,113 @@ HALIDE_REGISTER_GENERATOR(Gaussian3x3AutoGenerator, gaussian3x3_auto)
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
 #define STB_IMAGE_WRITE_IMPLEMENTATION  
 #include "../../../runtime/stb_image_write.h"
 
 #include "gaussian3x3_auto_aot.h"
+#include "gaussian3x3_batch_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
 
 using namespace Halide;
 
 int main(int argc, char **argv) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image>\n";
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [options]\n";
+        print_runner_flags(std::cerr);
         return 1;
     }
 
-    // Load input image using STB
-    int width, height, channels;
-    unsigned char *input_data = stbi_load(argv[1], &width, &height, &channels, 3);
-    if (!input_data) {
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
+        return 1;
+    }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
+
+    if (options.batch && options.pack) {
+        // Same-size images (or --tile thumbnails) in one call of the 4-D generator
+        return run_packed_batch(options, "gaussian3x3_batch", argv[1], argv[2], [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return gaussian3x3_auto(input.raw_buffer(), output.raw_buffer());
+        }, [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return gaussian3x3_batch(input.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.batch) {
+        return run_batch(options, "gaussian3x3_auto", argv[1], argv[2], [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return gaussian3x3_auto(input.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.stream) {
+        // One halo row above and below for the 3x3 kernel
+        return run_stream(options, "gaussian3x3_auto", argv[1], argv[2], 1, [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return gaussian3x3_auto(input.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "gaussian3x3_auto", argv[1], argv[2], [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return gaussian3x3_auto(input.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
         std::cerr << "Failed to load input image: " << argv[1] << "\n";
         return 1;
     }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
 
     std::cout << "Loaded image: " << width << "x" << height 
               << " (" << channels << " channels)\n";
 
-    // Create Halide buffer from loaded data
-    Buffer<uint8_t> input(width, height, 3);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                input(x, y, c) = input_data[(y * width + x) * 3 + c];
-            }
-        }
-    }
-    stbi_image_free(input_data);
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
 
-    // Prepare output buffer
-    Buffer<uint8_t> output(width, height, 3);
+    // Interleaved output doubles as the encoder input
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, 3);
 
-    // Single execution
+    // Warm-up and timed runs
     std::cout << "Processing image with auto-scheduled gaussian3x3...\n";
-    
-    int result = gaussian3x3_auto(input.raw_buffer(), output.raw_buffer());
-    
+
+    int result = run_benchmark(options, stats, [&] {
+        return gaussian3x3_auto(input.raw_buffer(), output.raw_buffer());
+    });
     if (result != 0) {
         std::cerr << "Error in gaussian blur\n";
         return 1;
     }
-
-    // Convert output to contiguous array for STB
-    unsigned char *output_data = new unsigned char[width * height * 3];
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                output_data[(y * width + x) * 3 + c] = output(x, y, c);
-            }
-        }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "gaussian3x3_auto")) {
+        return 1;
     }
 
-    // Save output using STB
-    const char *ext = strrchr(argv[2], '.');
-    bool success = false;
-    if (ext && strcmp(ext, ".png") == 0) {
-        success = stbi_write_png(argv[2], width, height, 3, output_data, width * 3);
-    } else if (ext && strcmp(ext, ".jpg") == 0) {
-        success = stbi_write_jpg(argv[2], width, height, 3, output_data, 95);
-    } else {
-        std::cerr << "Unsupported output format. Use .png or .jpg\n";
-    }
-    
-    delete[] output_data;
+    // Optional check against a reference image (a golden or a higher-precision variant)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
+
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
     
     if (!success) {
         std::cerr << "Failed to save output image\n";
@@ -126,5 +241,10 @@ int main(int argc, char **argv) {
     }
     
     std::cout << "Saved output: " << argv[2] << "\n";
-    return 0;
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "gaussian3x3_auto", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
 }
\ No newline at end of file
@@ -3,37 +3,74 @@
 
 using namespace Halide;
 
+// Brightness, contrast and gamma as run-time inputs. A pixel's result depends only on its
+// 8-bit value, so the adjustment is evaluated once per call into a 256-entry LUT and each
+// pixel becomes a single lookup. Pure brightness (contrast = gamma = 1) is a saturating
+// uint8 add and skips the LUT.
 class BrightnessAutoGenerator : public Halide::Generator<BrightnessAutoGenerator> {
 public:
+    // Frame size the autoscheduler tunes for; one build per size class
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
     Input<Buffer<uint8_t>> input{"input", 3};
+    Input<float> brightness{"brightness", 0.2f};  // offset as a fraction of full scale
+    Input<float> contrast{"contrast", 1.0f};      // gain around mid-gray, as in the DSL
+    Input<float> gamma{"gamma", 1.0f};            // output = level^(1/gamma)
     Output<Buffer<uint8_t>> output{"output", 3};
 
     void generate() {
-        Var x("x"), y("y"), c("c");
-
-        // Fixed brightness factor of 0.2 to match DSL behavior
-        const float brightness_factor = 0.2f;
-
-        // Convert to float and normalize to [0, 1]
-        Func input_float("input_float");
-        input_float(x, y, c) = cast<float>(input(x, y, c)) / 255.0f;
-
-        // Apply brightness adjustment
-        Func brightened("brightened");
-        brightened(x, y, c) = input_float(x, y, c) + brightness_factor;
-
-        // Clamp to [0, 1] range
-        Func clamped("clamped");
-        clamped(x, y, c) = clamp(brightened(x, y, c), 0.0f, 1.0f);
+        Var x("x"), y("y"), c("c"), i("i");
+
+        // Work in 0-255 levels with the offset rounded to a whole level, so contrast 1 and
+        // gamma 1 give exactly level + offset and the LUT agrees with the add path below.
+        // Offsets past +-255 saturate every pixel anyway; clamping keeps the int16 add exact.
+        Expr offset = clamp(round(brightness * 255.0f), -255.0f, 255.0f);
+        Expr level = clamp((cast<float>(i) - 127.5f) * contrast + 127.5f + offset, 0.0f, 255.0f);
+        level = select(gamma == 1.0f, level, 255.0f * pow(level / 255.0f, 1.0f / gamma));
+        Func lut("lut");
+        lut(i) = cast<uint8_t>(level + 0.5f);
+
+        Expr pure_brightness = contrast == 1.0f && gamma == 1.0f;
+        if (using_autoscheduler()) {
+            // The autoschedulers do not take specializations, so they get the LUT alone
+            output(x, y, c) = lut(cast<int32_t>(input(x, y, c)));
+        } else {
+            // The select is uniform per call; specialize() below folds it in each branch
+            Expr sum = cast<int16_t>(input(x, y, c)) + cast<int16_t>(offset);
+            output(x, y, c) = select(pure_brightness, cast<uint8_t>(clamp(sum, 0, 255)),
+                                     lut(cast<int32_t>(input(x, y, c))));
+        }
 
-        // Convert back to uint8
-        output(x, y, c) = cast<uint8_t>(clamped(x, y, c) * 255.0f);
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(3);
+        output.dim(2).set_stride(1).set_bounds(0, 3);
 
         // Set estimates for autoscheduler
-        input.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
-        output.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
-        
-        // No manual scheduling - let the autoscheduler handle everything
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        brightness.set_estimate(0.2f);
+        contrast.set_estimate(1.0f);
+        gamma.set_estimate(1.0f);
+
+        if (!using_autoscheduler()) {
+            // Hand-written schedule (the "manual" variant): the LUT once per call, then one
+            // parallel, vectorized pass of lookups (or adds) over the interleaved pixels
+            Var yo("yo"), yi("yi");
+            const int vec = natural_vector_size<uint8_t>();
+            lut.compute_root().vectorize(i, natural_vector_size<float>());
+            output.reorder(c, x, y).bound(c, 0, 3).unroll(c)
+                  .split(y, yo, yi, 32, TailStrategy::GuardWithIf).parallel(yo);
+            // Rows of whole vectors need no tail handling
+            auto vectorize_rows = [&](Stage stage) {
+                stage.specialize(output.dim(0).extent() % vec == 0).vectorize(x, vec, TailStrategy::RoundUp);
+                stage.vectorize(x, vec);
+            };
+            vectorize_rows(output.specialize(pure_brightness));
+            vectorize_rows(output);
+        }
     }
 };
 
@@ -44,79 +81,118 @@ HALIDE_REGISTER_GENERATOR(BrightnessAutoGenerator, brightness_auto)
 #include <iostream>
 #include <cstring>
 #include <cstdlib>
+#include <string>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
 #define STB_IMAGE_WRITE_IMPLEMENTATION  
 #include "../../../runtime/stb_image_write.h"
 
 #include "brightness_auto_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
 
 using namespace Halide;
 
 int main(int argc, char **argv) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image>\n";
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc < 3 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [brightness] [contrast] [gamma] [options]\n";
+        std::cerr << "Defaults: brightness=0.2, contrast=1, gamma=1\n";
+        print_runner_flags(std::cerr);
         return 1;
     }
 
-    // Load input image using STB
-    int width, height, channels;
-    unsigned char *input_data = stbi_load(argv[1], &width, &height, &channels, 3);
-    if (!input_data) {
+    // Adjustments are pipeline inputs, so any values run without regenerating
+    float brightness = argc >= 4 ? std::stof(argv[3]) : 0.2f;
+    float contrast = argc >= 5 ? std::stof(argv[4]) : 1.0f;
+    float gamma = argc >= 6 ? std::stof(argv[5]) : 1.0f;
+    if (gamma <= 0) {
+        std::cerr << "Gamma must be positive\n";
+        return 1;
+    }
+
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
+        return 1;
+    }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
+
+    if (options.batch) {
+        return run_batch(options, "brightness_auto", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return brightness_auto(input.raw_buffer(), brightness, contrast, gamma, output.raw_buffer());
+        });
+    }
+
+    if (options.stream) {
+        // Pointwise: no halo rows needed
+        return run_stream(options, "brightness_auto", argv[1], argv[2], 0, [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return brightness_auto(input.raw_buffer(), brightness, contrast, gamma, output.raw_buffer());
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "brightness_auto", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return brightness_auto(input.raw_buffer(), brightness, contrast, gamma, output.raw_buffer());
+        });
+    }
+
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
         std::cerr << "Failed to load input image: " << argv[1] << "\n";
         return 1;
     }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
 
     std::cout << "Loaded image: " << width << "x" << height 
               << " (" << channels << " channels)\n";
 
-    // Create Halide buffer from loaded data
-    Buffer<uint8_t> input(width, height, 3);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                input(x, y, c) = input_data[(y * width + x) * 3 + c];
-            }
-        }
-    }
-    stbi_image_free(input_data);
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
 
-    // Prepare output buffer
-    Buffer<uint8_t> output(width, height, 3);
+    // Interleaved output doubles as the encoder input
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, 3);
 
-    // Single execution
-    std::cout << "Processing image with auto-scheduled brightness (factor=0.2)...\n";
-    
-    int result = brightness_auto(input.raw_buffer(), output.raw_buffer());
-    
+    // Warm-up and timed runs
+    std::cout << "Processing image with brightness=" << brightness << ", contrast=" << contrast
+              << ", gamma=" << gamma << "...\n";
+
+    int result = run_benchmark(options, stats, [&] {
+        return brightness_auto(input.raw_buffer(), brightness, contrast, gamma, output.raw_buffer());
+    });
     if (result != 0) {
         std::cerr << "Error in brightness adjustment\n";
         return 1;
     }
-
-    // Convert output to contiguous array for STB
-    unsigned char *output_data = new unsigned char[width * height * 3];
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                output_data[(y * width + x) * 3 + c] = output(x, y, c);
-            }
-        }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "brightness_auto")) {
+        return 1;
     }
 
-    // Save output using STB
-    const char *ext = strrchr(argv[2], '.');
-    bool success = false;
-    if (ext && strcmp(ext, ".png") == 0) {
-        success = stbi_write_png(argv[2], width, height, 3, output_data, width * 3);
-    } else if (ext && strcmp(ext, ".jpg") == 0) {
-        success = stbi_write_jpg(argv[2], width, height, 3, output_data, 95);
-    } else {
-        std::cerr << "Unsupported output format. Use .png or .jpg\n";
-    }
-    
-    delete[] output_data;
+    // Optional check against a reference image (a golden or a higher-precision variant)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
+
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
     
     if (!success) {
         std::cerr << "Failed to save output image\n";
@@ -124,5 +200,10 @@ int main(int argc, char **argv) {
     }
     
     std::cout << "Saved output: " << argv[2] << "\n";
-    return 0;
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "brightness_auto", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
 }
\ No newline at end of file
@@ -1,17 +1,106 @@
 // Generator.cpp
 #include <Halide.h>
+#include <tuple>
 using namespace Halide;
 
+// How non-maximum suppression picks the neighbour pair across the edge
+enum class NmsMode {
+    Atan2,  // atan2 per pixel, converted to degrees and bucketed into four sectors
+    Ratio   // |gy| compared against tan(22.5) and tan(67.5) times |gx|: no trigonometry
+};
+
 class CannyGenerator : public Halide::Generator<CannyGenerator> {
 public:
+    // Integer front end: uint8 gray, separable [7 15 20 15 7] Gaussian in uint16 and int16
+    // Sobel, with thresholds compared against the squared magnitude
+    GeneratorParam<bool> fixed_point{"fixed_point", false};
+    // Direction quantization for the float pipeline; the fixed-point one always uses ratios
+    GeneratorParam<NmsMode> nms_mode{"nms_mode", NmsMode::Atan2,
+                                     {{"atan2", NmsMode::Atan2}, {"ratio", NmsMode::Ratio}}};
+    // 3 writes the edge map as RGB like the DSL; 1 writes a single 8-bit channel
+    GeneratorParam<int> output_channels{"output_channels", 3, 1, 3};
+    // Frame size the autoscheduler tunes for (one build per size class)
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
     Input<Buffer<uint8_t>> input{"input", 3};
     Input<float> low_threshold{"low_threshold", 0.1f};
     Input<float> high_threshold{"high_threshold", 0.3f};
     Output<Buffer<uint8_t>> output{"output", 3};
 
     void generate() {
-        Var x("x"), y("y"), c("c");
+        // Steps 1-5 produce edge_type: 0 = none, 1 = weak, 2 = strong
+        if (fixed_point) {
+            generate_fixed_point();
+        } else {
+            generate_float();
+        }
 
+        // Output edge types for all channels (hysteresis tracking in post-processing)
+        output(x, y, c) = edge_type(x, y);
+
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(output_channels);
+        output.dim(2).set_stride(1).set_bounds(0, output_channels);
+
+        // Set estimates for autoscheduler
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, output_channels}});
+        low_threshold.set_estimate(0.1f);
+        high_threshold.set_estimate(0.3f);
+
+        if (!using_autoscheduler()) {
+            // Hand-written schedule (the "manual" variant): parallel strips of rows with
+            // every stage sliding down the strip one row at a time, so intermediates stay
+            // a few rows tall; edge types are computed once per row for all output channels
+            Var yo("yo"), yi("yi");
+            const int vec = fixed_point ? natural_vector_size<int16_t>() : natural_vector_size<float>();
+            output.reorder(c, x, y).bound(c, 0, output_channels).unroll(c)
+                  .split(y, yo, yi, 32, TailStrategy::GuardWithIf).parallel(yo);
+            // Widths that are whole vectors store every row without a shifted last vector
+            output.specialize(output.dim(0).extent() % vec == 0).vectorize(x, vec, TailStrategy::RoundUp);
+            output.vectorize(x, vec);
+            for (Func f : stages) {
+                f.store_at(output, yo).compute_at(output, yi).vectorize(x, vec);
+            }
+        }
+    }
+
+private:
+    Var x{"x"}, y{"y"}, c{"c"};
+    Func edge_type{"edge_type"};
+    std::vector<Func> stages;  // intermediates the manual schedule places, in order
+
+    // Borders are taken from the input buffer's own min and extent rather than from 0, so a
+    // streaming runner can pass a strip of rows (with min set to its first image row) and,
+    // given enough halo rows, get exactly the rows the full-frame pipeline would produce
+    Region image_bounds() {
+        return {{input.dim(0).min(), input.dim(0).extent()}, {input.dim(1).min(), input.dim(1).extent()}};
+    }
+    // Pixels at least border away from the edges of the input
+    Expr inside(int border) {
+        return x >= input.dim(0).min() + border && x <= input.dim(0).max() - border &&
+               y >= input.dim(1).min() + border && y <= input.dim(1).max() - border;
+    }
+
+    // Neighbour pair along the gradient for the sector given by the ratio tests:
+    // horizontal (angle < 22.5 or >= 157.5), vertical (67.5 <= angle < 112.5), otherwise
+    // rising (22.5 <= angle < 67.5) or falling (112.5 <= angle < 157.5)
+    std::pair<Expr, Expr> sector_neighbours(Func m, Expr horizontal, Expr vertical, Expr rising) {
+        Expr mag1 = select(horizontal, m(x-1, y),
+                    select(vertical, m(x, y-1),
+                    select(rising, m(x+1, y-1),
+                                   m(x-1, y-1))));
+        Expr mag2 = select(horizontal, m(x+1, y),
+                    select(vertical, m(x, y+1),
+                    select(rising, m(x-1, y+1),
+                                   m(x+1, y+1))));
+        return {mag1, mag2};
+    }
+
+    void generate_float() {
         // Step 1: Convert to grayscale
         Func gray("gray");
         Expr r = cast<float>(input(x, y, 0)) / 255.0f;
@@ -32,9 +121,9 @@ public:
         };
         
         // Apply boundary conditions and compute gaussian
-        Func gray_clamped = BoundaryConditions::repeat_edge(gray, {{0, input.width()}, {0, input.height()}});
+        Func gray_clamped = BoundaryConditions::repeat_edge(gray, image_bounds());
         Expr gauss_sum = cast<float>(0);
-        Expr valid_gaussian = x >= 2 && x < input.width() - 2 && y >= 2 && y < input.height() - 2;
+        Expr valid_gaussian = inside(2);
         
         for (int dy = -2; dy <= 2; dy++) {
             for (int dx = -2; dx <= 2; dx++) {
@@ -45,8 +134,8 @@ public:
 
         // Step 3: Sobel gradients
         Func grad_x("grad_x"), grad_y("grad_y");
-        Func gaussian_clamped = BoundaryConditions::repeat_edge(gaussian, {{0, input.width()}, {0, input.height()}});
-        Expr valid_sobel = x >= 1 && x < input.width() - 1 && y >= 1 && y < input.height() - 1;
+        Func gaussian_clamped = BoundaryConditions::repeat_edge(gaussian, image_bounds());
+        Expr valid_sobel = inside(1);
         
         Expr gx = -gaussian_clamped(x-1, y-1) + gaussian_clamped(x+1, y-1) +
                   -2.0f * gaussian_clamped(x-1, y) + 2.0f * gaussian_clamped(x+1, y) +
@@ -58,59 +147,140 @@ public:
         grad_x(x, y) = select(valid_sobel, gx, 0.0f);
         grad_y(x, y) = select(valid_sobel, gy, 0.0f);
 
-        // Magnitude and direction
-        Func magnitude("magnitude"), direction("direction");
+        // Magnitude
+        Func magnitude("magnitude");
         magnitude(x, y) = sqrt(grad_x(x, y) * grad_x(x, y) + grad_y(x, y) * grad_y(x, y));
-        direction(x, y) = atan2(grad_y(x, y), grad_x(x, y));
 
         // Step 4: Non-maximum suppression
         Func nms("nms");
-        Func magnitude_clamped = BoundaryConditions::repeat_edge(magnitude, {{0, input.width()}, {0, input.height()}});
-        Expr valid_nms = x >= 1 && x < input.width() - 1 && y >= 1 && y < input.height() - 1;
-        
-        // Convert angle to degrees and normalize
-        Expr angle_rad = direction(x, y);
-        Expr angle = select(angle_rad < 0, angle_rad + 3.14159f, angle_rad);
-        angle = angle * 180.0f / 3.14159f;
+        Func magnitude_clamped = BoundaryConditions::repeat_edge(magnitude, image_bounds());
+        Expr valid_nms = inside(1);
         
         // Get interpolated magnitudes based on gradient direction
         Expr mag_curr = magnitude(x, y);
-        
-        // Determine which neighbors to compare based on angle
-        Expr cond1 = (angle >= 0 && angle < 22.5f) || (angle >= 157.5f && angle <= 180.0f);
-        Expr cond2 = angle >= 22.5f && angle < 67.5f;
-        Expr cond3 = angle >= 67.5f && angle < 112.5f;
-        Expr cond4 = angle >= 112.5f && angle < 157.5f;
-        
-        Expr mag1 = select(cond1, magnitude_clamped(x-1, y),
-                    select(cond2, magnitude_clamped(x+1, y-1),
-                    select(cond3, magnitude_clamped(x, y-1),
-                                  magnitude_clamped(x-1, y-1))));
-        
-        Expr mag2 = select(cond1, magnitude_clamped(x+1, y),
-                    select(cond2, magnitude_clamped(x-1, y+1),
-                    select(cond3, magnitude_clamped(x, y+1),
-                                  magnitude_clamped(x+1, y+1))));
+        Expr mag1, mag2;
+
+        if (nms_mode == NmsMode::Atan2) {
+            Func direction("direction");
+            direction(x, y) = atan2(grad_y(x, y), grad_x(x, y));
+
+            // Convert angle to degrees and normalize
+            Expr angle_rad = direction(x, y);
+            Expr angle = select(angle_rad < 0, angle_rad + 3.14159f, angle_rad);
+            angle = angle * 180.0f / 3.14159f;
+            
+            // Determine which neighbors to compare based on angle
+            Expr cond1 = (angle >= 0 && angle < 22.5f) || (angle >= 157.5f && angle <= 180.0f);
+            Expr cond2 = angle >= 22.5f && angle < 67.5f;
+            Expr cond3 = angle >= 67.5f && angle < 112.5f;
+            Expr cond4 = angle >= 112.5f && angle < 157.5f;
+            
+            mag1 = select(cond1, magnitude_clamped(x-1, y),
+                   select(cond2, magnitude_clamped(x+1, y-1),
+                   select(cond3, magnitude_clamped(x, y-1),
+                                 magnitude_clamped(x-1, y-1))));
+            
+            mag2 = select(cond1, magnitude_clamped(x+1, y),
+                   select(cond2, magnitude_clamped(x-1, y+1),
+                   select(cond3, magnitude_clamped(x, y+1),
+                                 magnitude_clamped(x+1, y+1))));
+        } else {
+            // Same four sectors from multiplies and compares only, so the stage vectorizes
+            Expr ax = abs(grad_x(x, y)), ay = abs(grad_y(x, y));
+            Expr horizontal = ay <= ax * 0.41421356f;  // tan(22.5)
+            Expr vertical = ay >= ax * 2.41421356f;    // tan(67.5)
+            Expr rising = (grad_x(x, y) > 0) == (grad_y(x, y) > 0);
+            std::tie(mag1, mag2) = sector_neighbours(magnitude_clamped, horizontal, vertical, rising);
+        }
         
         // Keep only local maxima
         nms(x, y) = select(valid_nms && mag_curr >= mag1 && mag_curr >= mag2, mag_curr, 0.0f);
 
         // Step 5: Double thresholding
-        Func edge_type("edge_type");
         edge_type(x, y) = select(nms(x, y) >= high_threshold, cast<uint8_t>(2),
                                select(nms(x, y) >= low_threshold, cast<uint8_t>(1),
                                       cast<uint8_t>(0)));
 
-        // Output edge types for all channels (hysteresis tracking in post-processing)
-        output(x, y, c) = edge_type(x, y);
+        stages = {gray, gaussian, grad_x, grad_y, magnitude, edge_type};
+    }
 
-        // Set estimates for autoscheduler
-        input.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
-        output.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
-        low_threshold.set_estimate(0.1f);
-        high_threshold.set_estimate(0.3f);
-        
-        // No manual scheduling - let the autoscheduler handle everything
+    void generate_fixed_point() {
+        // Step 1: Grayscale in uint8; weights scaled by 256 (77 + 150 + 29) fit 16-bit lanes
+        Func gray("gray");
+        Expr r = cast<uint16_t>(input(x, y, 0));
+        Expr g = cast<uint16_t>(input(x, y, 1));
+        Expr b = cast<uint16_t>(input(x, y, 2));
+        gray(x, y) = cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+
+        // Step 2: Separable 5x5 Gaussian, [7 15 20 15 7] / 64 per pass: the integer fit to the
+        // row and column sums of the float pipeline's /159 kernel. The horizontal pass peaks at
+        // 64 * 255 and is rounded to 2 fractional bits (0..1020) so the vertical one peaks at
+        // 64 * 1020; both stay in uint16. The result keeps 4 fractional bits: 0..4080 stands
+        // for the float pipeline's 0..1
+        const int fixed_one = 255 * 16;
+        const uint16_t taps[5] = {7, 15, 20, 15, 7};
+        Func gray_clamped = BoundaryConditions::repeat_edge(gray, image_bounds());
+        Func gaussian_x("gaussian_x"), gaussian("gaussian");
+        Expr sum_x = cast<uint16_t>(0);
+        for (int d = -2; d <= 2; d++) {
+            sum_x += taps[d + 2] * cast<uint16_t>(gray_clamped(x + d, y));
+        }
+        gaussian_x(x, y) = (sum_x + 8) >> 4;
+        Expr sum_y = cast<uint16_t>(0);
+        for (int d = -2; d <= 2; d++) {
+            sum_y += taps[d + 2] * gaussian_x(x, y + d);
+        }
+        Expr valid_gaussian = inside(2);
+        gaussian(x, y) = select(valid_gaussian, (sum_y + 8) >> 4, cast<uint16_t>(0));
+
+        // Step 3: Sobel in int16; |gradient| <= 4 * 4080 = 16320
+        Func grad_x("grad_x"), grad_y("grad_y");
+        Func gaussian_clamped = BoundaryConditions::repeat_edge(gaussian, image_bounds());
+        Expr valid_sobel = inside(1);
+        auto gs = [&](int dx, int dy) { return cast<int16_t>(gaussian_clamped(x + dx, y + dy)); };
+
+        Expr gx = -gs(-1, -1) + gs(1, -1) - 2 * gs(-1, 0) + 2 * gs(1, 0) - gs(-1, 1) + gs(1, 1);
+        Expr gy = -gs(-1, -1) - 2 * gs(0, -1) - gs(1, -1) + gs(-1, 1) + 2 * gs(0, 1) + gs(1, 1);
+
+        grad_x(x, y) = select(valid_sobel, gx, cast<int16_t>(0));
+        grad_y(x, y) = select(valid_sobel, gy, cast<int16_t>(0));
+
+        // Squared magnitude in int32 (at most 2 * 16320^2); it orders like the magnitude,
+        // so NMS and thresholds need no square root
+        Func magnitude("magnitude");
+        Expr gx32 = cast<int32_t>(grad_x(x, y)), gy32 = cast<int32_t>(grad_y(x, y));
+        magnitude(x, y) = gx32 * gx32 + gy32 * gy32;
+
+        // Step 4: Non-maximum suppression with the four direction sectors found by comparing
+        // |gy| against tan(22.5) and tan(67.5) times |gx| (scaled by 2^15)
+        Func nms("nms");
+        Func magnitude_clamped = BoundaryConditions::repeat_edge(magnitude, image_bounds());
+        Expr valid_nms = inside(1);
+
+        Expr ax = abs(gx32), ay = abs(gy32);
+        Expr horizontal = ay * 32768 <= ax * 13573;
+        Expr vertical = ay * 32768 >= ax * 79109;
+        Expr rising = (gx32 > 0) == (gy32 > 0);
+
+        Expr mag_curr = magnitude(x, y);
+        Expr mag1, mag2;
+        std::tie(mag1, mag2) = sector_neighbours(magnitude_clamped, horizontal, vertical, rising);
+
+        // Keep only local maxima
+        nms(x, y) = select(valid_nms && mag_curr >= mag1 && mag_curr >= mag2, mag_curr, 0);
+
+        // Step 5: Double thresholding; magnitude >= t  <=>  squared magnitude >= ceil((t * 4080)^2)
+        auto squared_threshold = [&](Expr t) {
+            Expr scaled = t * fixed_one;
+            return select(t <= 0.0f, 0, cast<int32_t>(min(ceil(scaled * scaled), 2.0e9f)));
+        };
+        Expr high = squared_threshold(high_threshold);
+        Expr low = squared_threshold(low_threshold);
+        edge_type(x, y) = select(nms(x, y) >= high, cast<uint8_t>(2),
+                               select(nms(x, y) >= low, cast<uint8_t>(1),
+                                      cast<uint8_t>(0)));
+
+        stages = {gray, gaussian_x, gaussian, grad_x, grad_y, magnitude, edge_type};
     }
 };
 
@@ -118,26 +288,275 @@ HALIDE_REGISTER_GENERATOR(CannyGenerator, canny_auto)
 
 // Runner.cpp
 #include <Halide.h>
-#include <chrono>
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
 #define STB_IMAGE_WRITE_IMPLEMENTATION  
 #include "../../../runtime/stb_image_write.h"
 
 #include "canny_auto_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
 
 using namespace Halide;
 
+// build-halide.sh defines HL_PARAM_<name> for each generator param of a variant build
+#ifndef HL_PARAM_output_channels
+#define HL_PARAM_output_channels 3
+#endif
+
+// Per-pixel scratch for hysteresis. Callers keep one across calls, so repeated runs at one size
+// allocate it once; concurrent calls each need their own.
+struct HysteresisScratch {
+    std::vector<int32_t> parent;
+    std::unique_ptr<std::atomic<uint8_t>[]> has_strong;
+    size_t has_strong_size = 0;
+
+    size_t bytes() const { return parent.capacity() * sizeof(int32_t) + has_strong_size; }
+};
+
+// Hysteresis tracking: keep weak edges (1) that are 8-connected to a strong edge (2) through
+// interior weak pixels, then write 0/255 to every channel. Same result as repeatedly sweeping
+// the image until nothing changes, but linear time: union-find runs per row band in parallel,
+// band seams are merged serially, and the components holding a strong pixel are kept.
+static void hysteresis(Buffer<uint8_t> &edges, HysteresisScratch &scratch) {
+    const int width = edges.width();
+    const int height = edges.height();
+    const int channels = edges.channels();
+    const int x_stride = edges.dim(0).stride();
+    const int y_stride = edges.dim(1).stride();
+    const int c_stride = edges.dim(2).stride();
+    uint8_t *data = edges.data();
+
+    auto value = [&](int x, int y) { return data[y * y_stride + x * x_stride]; };
+
+    // Strong pixels anywhere, weak pixels only away from the border (the sweep never visits it)
+    auto is_node = [&](int x, int y) {
+        uint8_t v = value(x, y);
+        return v == 2 || (v == 1 && x > 0 && x < width - 1 && y > 0 && y < height - 1);
+    };
+
+    // Pass 1 overwrites every parent entry and clears has_strong, so stale scratch is harmless
+    std::vector<int32_t> &parent = scratch.parent;
+    std::unique_ptr<std::atomic<uint8_t>[]> &has_strong = scratch.has_strong;
+    const size_t pixels = (size_t)width * height;
+    parent.resize(pixels);
+    if (scratch.has_strong_size < pixels) {
+        has_strong.reset(new std::atomic<uint8_t>[pixels]);
+        scratch.has_strong_size = pixels;
+    }
+
+    auto find = [&](int32_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+    // Read-only find, safe to run concurrently once all unions are done
+    auto find_root = [&](int32_t i) {
+        while (parent[i] != i) {
+            i = parent[i];
+        }
+        return i;
+    };
+    // Link the larger root under the smaller one so roots never move between bands
+    auto unite = [&](int32_t a, int32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a < b) {
+            parent[b] = a;
+        } else if (b < a) {
+            parent[a] = b;
+        }
+    };
+
+    const int num_bands = std::min(host_thread_count(), height);
+    const int band_height = (height + num_bands - 1) / num_bands;
+    // Bands go to the Halide runtime's thread pool, already warm from the pipeline, instead of
+    // threads started and joined for every pass
+    auto for_each_band = [&](auto &&body) {
+        struct Bands {
+            decltype(&body) run;
+            int band_height, height;
+        } bands{&body, band_height, height};
+        auto task = [](void *, int band, uint8_t *closure) {
+            const Bands &b = *(const Bands *)closure;
+            int y0 = band * b.band_height;
+            (*b.run)(y0, std::min(y0 + b.band_height, b.height));
+            return 0;
+        };
+        halide_do_par_for(nullptr, task, 0, (height + band_height - 1) / band_height, (uint8_t *)&bands);
+    };
+
+    // Pass 1: label each band independently (only touches parent entries inside the band)
+    for_each_band([&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            for (int x = 0; x < width; x++) {
+                int32_t i = y * width + x;
+                has_strong[i].store(0, std::memory_order_relaxed);
+                if (!is_node(x, y)) {
+                    parent[i] = -1;
+                    continue;
+                }
+                parent[i] = i;
+                if (x > 0 && parent[i - 1] >= 0) unite(i, i - 1);
+                if (y > y0) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        if (x + dx >= 0 && x + dx < width && parent[i - width + dx] >= 0) {
+                            unite(i, i - width + dx);
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    // Pass 2: stitch each band's first row to the last row of the band above
+    for (int y = band_height; y < height; y += band_height) {
+        for (int x = 0; x < width; x++) {
+            int32_t i = y * width + x;
+            if (parent[i] < 0) continue;
+            for (int dx = -1; dx <= 1; dx++) {
+                if (x + dx >= 0 && x + dx < width && parent[i - width + dx] >= 0) {
+                    unite(i, i - width + dx);
+                }
+            }
+        }
+    }
+
+    // Pass 3: flag components containing a strong pixel
+    for_each_band([&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            for (int x = 0; x < width; x++) {
+                if (value(x, y) == 2) {
+                    has_strong[find_root(y * width + x)].store(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+
+    // Pass 4: convert to final output (0 or 255)
+    for_each_band([&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            for (int x = 0; x < width; x++) {
+                int32_t i = y * width + x;
+                uint8_t out = (parent[i] >= 0 && has_strong[find_root(i)].load(std::memory_order_relaxed)) ? 255 : 0;
+                for (int c = 0; c < channels; c++) {
+                    data[y * y_stride + x * x_stride + c * c_stride] = out;
+                }
+            }
+        }
+    });
+}
+
+// Streaming Canny: the pipeline runs per strip with 4 halo rows (2 for the 5x5 blur, 1 each for
+// Sobel and NMS), but hysteresis connects edges across the whole image. Edge types are kept in
+// a one-byte plane until the last strip is done; hysteresis then runs on the plane (its labels
+// are per pixel too) and rows are expanded to RGB as they are written (single-channel builds
+// write the plane as is). That is about 6 bytes per pixel instead of the 11 the full-frame
+// path holds.
+static int stream_canny(const RunnerOptions &options, const char *in_path, const char *out_path,
+                        float low_threshold, float high_threshold) {
+    if (!is_ppm_path(out_path)) {
+        std::cerr << "Streaming writes binary PPM/PGM; use a .ppm or .pgm output path\n";
+        return 1;
+    }
+    PpmReader reader;
+    if (!reader.open(in_path)) {
+        return 1;
+    }
+    const int out_channels = options.output_channels;
+    PpmWriter writer;
+    if (!writer.open(out_path, reader.width(), reader.height(), out_channels)) {
+        std::cerr << "Failed to open output image: " << out_path << "\n";
+        return 1;
+    }
+    const int width = reader.width();
+    const int height = reader.height();
+
+    StreamStats stats;
+    auto wall_start = BenchClock::now();
+    Buffer<uint8_t> edges(width, height, 1);
+    int result = for_each_strip(reader, options, 4, stats, [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+        return canny_auto(input.raw_buffer(), low_threshold, high_threshold, output.raw_buffer());
+    }, [&](Buffer<uint8_t> &output) {
+        // Rows keep their image coordinates; the channels all hold the same edge type
+        const int y_min = output.dim(1).min();
+        for (int y = y_min; y < y_min + output.height(); y++) {
+            for (int x = 0; x < width; x++) {
+                edges(x, y, 0) = output(x, y, 0);
+            }
+        }
+        return 0;
+    });
+    if (result != 0) {
+        return result;
+    }
+
+    auto compute_start = BenchClock::now();
+    HysteresisScratch scratch;
+    hysteresis(edges, scratch);
+    stats.compute_ms += elapsed_ms(compute_start);
+
+    auto write_start = BenchClock::now();
+    std::vector<uint8_t> row((size_t)width * out_channels);
+    for (int y = 0; y < height; y++) {
+        const uint8_t *src = &edges(0, y, 0);
+        if (out_channels == 3) {
+            for (int x = 0; x < width; x++) {
+                row[x * 3] = row[x * 3 + 1] = row[x * 3 + 2] = src[x];
+            }
+            src = row.data();
+        }
+        if (!writer.write_rows(src, 1)) {
+            std::cerr << "Failed to write output image: " << out_path << "\n";
+            return 1;
+        }
+    }
+    stats.write_ms += elapsed_ms(write_start);
+    // The edge plane and hysteresis' labels held next to the strip buffers
+    stats.buffer_bytes += (size_t)width * height + scratch.bytes() + row.size();
+    stats.wall_ms = elapsed_ms(wall_start);
+    stats.arena = HalideArena::instance().stats();
+
+    print_stream_stats(std::cout, stats);
+    if (!options.stats_path.empty() && !write_stream_stats_json(options.stats_path, "canny_auto", stats)) {
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char **argv) {
-    if (argc < 3 || argc > 5) {
-        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [low_threshold] [high_threshold]\n";
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc < 3 || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [low_threshold] [high_threshold] [options]\n";
         std::cerr << "Default thresholds: low=0.1, high=0.3\n";
+        print_runner_flags(std::cerr);
+        return 1;
+    }
+    options.output_channels = HL_PARAM_output_channels;
+
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
         return 1;
     }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
 
     // Parse thresholds
     float low_threshold = 0.1f;
@@ -150,107 +569,90 @@ int main(int argc, char **argv) {
         high_threshold = std::stof(argv[4]);
     }
 
-    // Load input image using STB
-    int width, height, channels;
-    unsigned char *input_data = stbi_load(argv[1], &width, &height, &channels, 3);
-    if (!input_data) {
+    // One scratch per runner: batch, serve and the timed runs call hysteresis one frame at a time
+    HysteresisScratch scratch;
+    if (options.batch) {
+        return run_batch(options, "canny_auto", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            if (int error = canny_auto(input.raw_buffer(), low_threshold, high_threshold, output.raw_buffer())) {
+                return error;
+            }
+            hysteresis(output, scratch);
+            return 0;
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "canny_auto", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            if (int error = canny_auto(input.raw_buffer(), low_threshold, high_threshold, output.raw_buffer())) {
+                return error;
+            }
+            hysteresis(output, scratch);
+            return 0;
+        });
+    }
+
+    if (options.stream) {
+        return stream_canny(options, argv[1], argv[2], low_threshold, high_threshold);
+    }
+
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
         std::cerr << "Failed to load input image: " << argv[1] << "\n";
         return 1;
     }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
 
     std::cout << "Loaded image: " << width << "x" << height 
               << " (" << channels << " channels)\n";
     std::cout << "Using thresholds: low=" << low_threshold << ", high=" << high_threshold << "\n";
 
-    // Create Halide buffer from loaded data
-    Buffer<uint8_t> input(width, height, 3);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                input(x, y, c) = input_data[(y * width + x) * 3 + c];
-            }
-        }
-    }
-    stbi_image_free(input_data);
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
 
-    // Prepare output buffer
-    Buffer<uint8_t> output(width, height, 3);
+    // Interleaved output doubles as the encoder input (RGB, or gray for single-channel builds)
+    const int out_channels = options.output_channels;
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, out_channels);
 
-    // Single execution
+    // Warm-up and timed runs; each run includes the host-side hysteresis
     std::cout << "Processing image with auto-scheduled Canny edge detection...\n";
-    
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    int result = canny_auto(input.raw_buffer(), low_threshold, high_threshold, output.raw_buffer());
-    
+
+    // Hysteresis runs on the host, so it is timed here for the per-stage profile
+    HostStage hysteresis_stage{"hysteresis"};
+    int result = run_benchmark(options, stats, [&] {
+        if (int error = canny_auto(input.raw_buffer(), low_threshold, high_threshold, output.raw_buffer())) {
+            return error;
+        }
+        // Apply hysteresis tracking and convert to final output (0 or 255)
+        auto hysteresis_start = BenchClock::now();
+        hysteresis(output, scratch);
+        hysteresis_stage.total_ms += elapsed_ms(hysteresis_start);
+        return 0;
+    });
     if (result != 0) {
         std::cerr << "Error in Canny edge detection\n";
         return 1;
     }
-
-    // Apply hysteresis tracking
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (int y = 1; y < height - 1; y++) {
-            for (int x = 1; x < width - 1; x++) {
-                if (output(x, y, 0) == 1) {  // Weak edge
-                    // Check 8-connected neighbors
-                    for (int dy = -1; dy <= 1; dy++) {
-                        for (int dx = -1; dx <= 1; dx++) {
-                            if (dx == 0 && dy == 0) continue;
-                            if (output(x + dx, y + dy, 0) == 2) {  // Strong edge
-                                output(x, y, 0) = 2;
-                                output(x, y, 1) = 2;
-                                output(x, y, 2) = 2;
-                                changed = true;
-                                goto next_pixel;
-                            }
-                        }
-                    }
-                    next_pixel:;
-                }
-            }
-        }
-    }
-    
-    // Convert to final output (0 or 255)
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            uint8_t value = (output(x, y, 0) == 2) ? 255 : 0;
-            output(x, y, 0) = value;
-            output(x, y, 1) = value;
-            output(x, y, 2) = value;
-        }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "canny_auto", {hysteresis_stage})) {
+        return 1;
     }
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    
-    std::cout << "Canny edge detection execution time: " << duration.count() << " microseconds\n";
 
-    // Convert output to contiguous array for STB
-    unsigned char *output_data = new unsigned char[width * height * 3];
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                output_data[(y * width + x) * 3 + c] = output(x, y, c);
-            }
-        }
-    }
+    // Optional check against a reference image (a golden or a higher-precision variant)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
 
-    // Save output using STB
-    const char *ext = strrchr(argv[2], '.');
-    bool success = false;
-    if (ext && strcmp(ext, ".png") == 0) {
-        success = stbi_write_png(argv[2], width, height, 3, output_data, width * 3);
-    } else if (ext && strcmp(ext, ".jpg") == 0) {
-        success = stbi_write_jpg(argv[2], width, height, 3, output_data, 95);
-    } else {
-        std::cerr << "Unsupported output format. Use .png or .jpg\n";
-    }
-    
-    delete[] output_data;
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
     
     if (!success) {
         std::cerr << "Failed to save output image\n";
@@ -258,5 +660,10 @@ int main(int argc, char **argv) {
     }
     
     std::cout << "Saved output: " << argv[2] << "\n";
-    return 0;
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "canny_auto", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+// halide_arena.h
+// Pooled heap for Halide's intermediate buffers. Without it every Func the schedule
+// materializes on the heap is malloc'd and freed on every call (once per strip for
+// buffers computed inside a parallel loop), which churns the allocator and lets RSS
+// spike in long-running runners. The arena keeps freed blocks in per-size free lists and
+// hands them back on the next request, so the first call sizes the pool and later calls
+// of the same pipeline at the same size never reach the system allocator. Blocks are
+// 128-byte aligned. Idle blocks are capped (--arena-limit, default 256 MiB): past the cap
+// the least recently used sizes go back to the system first. trim() releases every idle
+// block, and trim_unused_since() only those of sizes not used since a mark from now(), so
+// batch mode can drop an image size it stops caching without touching the ones it keeps.
+//
+// Runners install it with install_halide_arena(options) unless --no-arena is given;
+// run_benchmark and the batch, stream and serve modes report its statistics.
+#pragma once
+
+#include <HalideRuntime.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "runner_options.h"
+
+struct ArenaStats {
+    bool enabled = false;
+    size_t peak_bytes = 0;          // high-water mark of bytes handed to Halide since the last trim
+    size_t reserved_bytes = 0;      // bytes held from the system: in use plus pooled
+    uint64_t allocations = 0;       // halide_malloc calls
+    uint64_t system_allocations = 0;  // of which not served from the pool
+    uint64_t released_blocks = 0;   // idle blocks returned to the system (cap or trim)
+};
+
+class HalideArena {
+public:
+    static constexpr size_t kAlignment = 128;
+    static constexpr size_t kDefaultLimit = size_t(256) << 20;
+
+    // Never destroyed: Halide may still free buffers while static destructors run
+    static HalideArena &instance() {
+        static HalideArena *arena = new HalideArena;
+        return *arena;
+    }
+
+    void install(size_t limit = kDefaultLimit) {
+        halide_set_custom_malloc(&HalideArena::halide_allocate);
+        halide_set_custom_free(&HalideArena::halide_release);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.enabled = true;
+        limit_ = limit;
+    }
+
+    // Returns every idle block to the system and restarts the peak from what is in use
+    void trim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &entry : free_) {
+            while (!entry.second.blocks.empty()) {
+                release_block(entry.first, entry.second);
+            }
+        }
+        free_.clear();
+        stats_.peak_bytes = in_use_;
+    }
+
+    ArenaStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    // Position on the allocation clock, for trim_unused_since()
+    uint64_t now() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return clock_;
+    }
+
+    // Returns the idle blocks of every size not allocated or freed after mark
+    void trim_unused_since(uint64_t mark) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = free_.begin(); it != free_.end();) {
+            if (it->second.last_use > mark) {
+                ++it;
+                continue;
+            }
+            while (!it->second.blocks.empty()) {
+                release_block(it->first, it->second);
+            }
+            it = free_.erase(it);
+        }
+    }
+
+    void *allocate(size_t size) {
+        const size_t block = block_size(size);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.allocations++;
+        SizeClass &size_class = free_[block];
+        size_class.last_use = ++clock_;
+        uint8_t *base;
+        if (!size_class.blocks.empty()) {
+            base = size_class.blocks.back();
+            size_class.blocks.pop_back();
+            pooled_ -= block;
+        } else {
+            base = (uint8_t *)std::aligned_alloc(kAlignment, kAlignment + block);
+            if (!base) {
+                return nullptr;
+            }
+            stats_.system_allocations++;
+            stats_.reserved_bytes += block;
+        }
+        // The block size sits in the header ahead of the aligned payload
+        *(size_t *)base = block;
+        in_use_ += block;
+        stats_.peak_bytes = std::max(stats_.peak_bytes, in_use_);
+        return base + kAlignment;
+    }
+
+    void release(void *ptr) {
+        if (!ptr) {
+            return;
+        }
+        uint8_t *base = (uint8_t *)ptr - kAlignment;
+        const size_t block = *(size_t *)base;
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_use_ -= block;
+        SizeClass &size_class = free_[block];
+        size_class.blocks.push_back(base);
+        size_class.last_use = ++clock_;
+        pooled_ += block;
+        if (pooled_ > limit_) {
+            evict();
+        }
+    }
+
+private:
+    struct SizeClass {
+        std::vector<uint8_t *> blocks;  // idle blocks of this size
+        uint64_t last_use = 0;          // clock_ at the last allocate or release
+    };
+
+    HalideArena() = default;
+
+    // Frees idle blocks of the least recently used sizes until the pool is back under the
+    // cap; the size just released is used most recently, so it goes last
+    void evict() {
+        while (pooled_ > limit_) {
+            auto oldest = free_.end();
+            for (auto it = free_.begin(); it != free_.end(); ++it) {
+                if (!it->second.blocks.empty() &&
+                    (oldest == free_.end() || it->second.last_use < oldest->second.last_use)) {
+                    oldest = it;
+                }
+            }
+            if (oldest == free_.end()) {
+                return;
+            }
+            while (!oldest->second.blocks.empty() && pooled_ > limit_) {
+                release_block(oldest->first, oldest->second);
+            }
+        }
+    }
+
+    void release_block(size_t block, SizeClass &size_class) {
+        std::free(size_class.blocks.back());
+        size_class.blocks.pop_back();
+        pooled_ -= block;
+        stats_.reserved_bytes -= block;
+        stats_.released_blocks++;
+    }
+
+    // Rounds up to a multiple of an eighth of the size's power of two (at least the
+    // alignment), so strips whose buffers differ by a few rows still share blocks while
+    // wasting at most 12.5%
+    static size_t block_size(size_t size) {
+        size_t step = kAlignment;
+        while (step * 16 <= size) {
+            step *= 2;
+        }
+        return std::max(kAlignment, (size + step - 1) / step * step);
+    }
+
+    static void *halide_allocate(void *, size_t size) { return instance().allocate(size); }
+    static void halide_release(void *, void *ptr) { instance().release(ptr); }
+
+    std::mutex mutex_;
+    std::unordered_map<size_t, SizeClass> free_;
+    size_t in_use_ = 0;
+    size_t pooled_ = 0;   // bytes in idle blocks
+    size_t limit_ = kDefaultLimit;
+    uint64_t clock_ = 0;  // allocate/release counter ordering the sizes by last use
+    ArenaStats stats_;
+};
+
+inline void install_halide_arena(const RunnerOptions &options) {
+    if (options.arena) {
+        HalideArena::instance().install(options.arena_limit_mib << 20);
+    }
+}
+
+// Counters accumulated between two snapshots; sizes are those at the later one
+inline ArenaStats arena_stats_since(const ArenaStats &before, const ArenaStats &after) {
+    ArenaStats stats = after;
+    stats.allocations -= before.allocations;
+    stats.system_allocations -= before.system_allocations;
+    stats.released_blocks -= before.released_blocks;
+    return stats;
+}
+
+inline void print_arena_stats(std::ostream &os, const ArenaStats &stats) {
+    if (!stats.enabled) {
+        return;
+    }
+    os << std::fixed << std::setprecision(2)
+       << "Arena: peak " << stats.peak_bytes / 1048576.0 << " MiB in use, "
+       << stats.reserved_bytes / 1048576.0 << " MiB reserved; " << stats.allocations
+       << " allocations, " << stats.system_allocations << " from the system, "
+       << stats.released_blocks << " blocks released\n"
+       << std::defaultfloat;
+}
+
+// Appends the statistics as fields of an open JSON object
+inline void write_arena_json(std::ostream &out, const ArenaStats &stats) {
+    if (!stats.enabled) {
+        return;
+    }
+    out << ",\n  \"arena_peak_bytes\": " << stats.peak_bytes << ",\n"
+        << "  \"arena_reserved_bytes\": " << stats.reserved_bytes << ",\n"
+        << "  \"arena_allocations\": " << stats.allocations << ",\n"
+        << "  \"arena_system_allocations\": " << stats.system_allocations << ",\n"
+        << "  \"arena_released_blocks\": " << stats.released_blocks;
+}
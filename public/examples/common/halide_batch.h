@@ -0,0 +1,473 @@
+// halide_batch.h
+// Batch mode for the Halide example runners: one process walks a directory or a
+// manifest of images (e.g. the Kodak Image Suite), decodes image N+1 on a worker
+// thread while image N is processed, reuses output buffers across images of the
+// same size and reports aggregate throughput at the end. Images are loaded and saved
+// through halide_image_io.h, so PPM inputs are memory-mapped.
+//
+// With --pack (grayscale and blur, which have batched 4-D generators) all images are
+// decoded up front, optionally cut into --tile WxH thumbnails, and packed by size into
+// (x, y, c, n) buffers. One call per size is then timed against a loop of one call per
+// image on the same pixels, and the two outputs must match.
+//
+// Include after stb_image.h and stb_image_write.h.
+#pragma once
+
+#include <Halide.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "halide_bench.h"
+#include "halide_image_io.h"
+
+struct BatchImage {
+    std::string path;
+    LoadedImage pixels;
+    bool loaded = false;
+    double decode_ms = 0;
+};
+
+struct BatchStats {
+    int images = 0;
+    int failed = 0;
+    int buffer_allocations = 0;  // output buffers created; the rest were reused
+    double megapixels = 0;
+    double wall_ms = 0;
+    double compute_ms = 0;
+    double decode_ms = 0;  // overlapped with compute
+    double encode_ms = 0;
+    ArenaStats arena;
+};
+
+struct PackedStats {
+    int images = 0;
+    int groups = 0;  // distinct sizes, one packed call each
+    int tile_width = 0;
+    int tile_height = 0;
+    double megapixels = 0;
+    double decode_ms = 0;
+    double encode_ms = 0;
+    BenchStats loop;    // one call per image
+    BenchStats packed;  // one call per size
+    bool identical = false;
+};
+
+// A directory is scanned for images (sorted by name); any other path is read as a
+// manifest with one image path per line, relative to the manifest. Blank lines and
+// lines starting with '#' are skipped.
+inline std::vector<std::string> list_batch_inputs(const std::string &source) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths;
+    if (fs::is_directory(source)) {
+        const std::vector<std::string> extensions = {".png", ".jpg", ".jpeg", ".bmp", ".tga", ".ppm", ".pgm"};
+        for (const auto &entry : fs::directory_iterator(source)) {
+            std::string ext = entry.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (entry.is_regular_file() && std::find(extensions.begin(), extensions.end(), ext) != extensions.end()) {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+    } else {
+        std::ifstream manifest(source);
+        fs::path base = fs::path(source).parent_path();
+        std::string line;
+        while (std::getline(manifest, line)) {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (line.empty() || line[0] == '#') continue;
+            fs::path p(line);
+            paths.push_back((p.is_absolute() ? p : base / p).string());
+        }
+    }
+    return paths;
+}
+
+inline BatchImage decode_batch_image(const std::string &path) {
+    BatchImage image;
+    image.path = path;
+    auto start = BenchClock::now();
+    image.loaded = image.pixels.load(path);
+    image.decode_ms = elapsed_ms(start);
+    return image;
+}
+
+inline void print_batch_stats(std::ostream &os, const BatchStats &stats) {
+    double wall_s = stats.wall_ms / 1000.0;
+    os << std::fixed << std::setprecision(2)
+       << "Batch: " << stats.images << " images (" << stats.failed << " failed), "
+       << stats.megapixels << " MP in " << wall_s << " s\n"
+       << "Throughput: " << stats.images / wall_s << " images/s, " << stats.megapixels / wall_s
+       << " MP/s end-to-end, " << stats.megapixels * 1000.0 / stats.compute_ms << " MP/s compute\n"
+       << "Time: compute " << stats.compute_ms << " ms, decode " << stats.decode_ms
+       << " ms (overlapped), encode " << stats.encode_ms << " ms\n"
+       << "Output buffers allocated: " << stats.buffer_allocations << "\n"
+       << std::defaultfloat;
+    print_arena_stats(os, stats.arena);
+}
+
+inline bool write_batch_stats_json(const std::string &path, const std::string &pipeline, const BatchStats &stats) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write stats: " << path << "\n";
+        return false;
+    }
+    double wall_s = stats.wall_ms / 1000.0;
+    out << std::fixed << std::setprecision(4)
+        << "{\n"
+        << "  \"pipeline\": \"" << pipeline << "\",\n"
+        << "  \"mode\": \"batch\",\n"
+        << "  \"images\": " << stats.images << ",\n"
+        << "  \"failed\": " << stats.failed << ",\n"
+        << "  \"megapixels\": " << stats.megapixels << ",\n"
+        << "  \"wall_ms\": " << stats.wall_ms << ",\n"
+        << "  \"compute_ms\": " << stats.compute_ms << ",\n"
+        << "  \"decode_ms\": " << stats.decode_ms << ",\n"
+        << "  \"encode_ms\": " << stats.encode_ms << ",\n"
+        << "  \"images_per_s\": " << stats.images / wall_s << ",\n"
+        << "  \"mpix_per_s\": " << stats.megapixels / wall_s << ",\n"
+        << "  \"buffer_allocations\": " << stats.buffer_allocations;
+    write_arena_json(out, stats.arena);
+    out << "\n}\n";
+    return (bool)out;
+}
+
+inline double images_per_s(int images, const BenchStats &timing) {
+    return timing.median_ms > 0 ? images * 1000.0 / timing.median_ms : 0;
+}
+
+inline void print_packed_stats(std::ostream &os, const PackedStats &stats) {
+    os << std::fixed << std::setprecision(2)
+       << "Packed: " << stats.images << " images in " << stats.groups << " calls, "
+       << stats.megapixels << " MP per pass (" << stats.loop.iterations << " runs, "
+       << stats.loop.warmup << " warm-up, " << stats.loop.threads << " threads)\n"
+       << "Per-image calls: median " << stats.loop.median_ms << " ms, "
+       << images_per_s(stats.images, stats.loop) << " images/s\n"
+       << "Packed calls: median " << stats.packed.median_ms << " ms, "
+       << images_per_s(stats.images, stats.packed) << " images/s ("
+       << stats.loop.median_ms / stats.packed.median_ms << "x)\n"
+       << "Outputs " << (stats.identical ? "identical" : "DIFFER") << "; decode "
+       << stats.decode_ms << " ms, encode " << stats.encode_ms << " ms\n"
+       << std::defaultfloat;
+    print_arena_stats(os, stats.packed.arena);
+}
+
+inline void write_packed_timing_json(std::ostream &out, const char *name, int images, const BenchStats &timing) {
+    out << "  \"" << name << "\": {\n"
+        << "    \"min_ms\": " << timing.min_ms << ",\n"
+        << "    \"median_ms\": " << timing.median_ms << ",\n"
+        << "    \"p95_ms\": " << timing.p95_ms << ",\n"
+        << "    \"mean_ms\": " << timing.mean_ms << ",\n"
+        << "    \"mpix_per_s\": " << timing.mpix_per_s << ",\n"
+        << "    \"images_per_s\": " << images_per_s(images, timing) << "\n"
+        << "  }";
+}
+
+inline bool write_packed_stats_json(const std::string &path, const std::string &pipeline, const PackedStats &stats) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write stats: " << path << "\n";
+        return false;
+    }
+    out << std::fixed << std::setprecision(4)
+        << "{\n"
+        << "  \"pipeline\": \"" << pipeline << "\",\n"
+        << "  \"mode\": \"packed\",\n"
+        << "  \"threads\": " << stats.packed.threads << ",\n"
+        << "  \"images\": " << stats.images << ",\n"
+        << "  \"groups\": " << stats.groups << ",\n"
+        << "  \"tile_width\": " << stats.tile_width << ",\n"
+        << "  \"tile_height\": " << stats.tile_height << ",\n"
+        << "  \"megapixels\": " << stats.megapixels << ",\n"
+        << "  \"warmup\": " << stats.packed.warmup << ",\n"
+        << "  \"iterations\": " << stats.packed.iterations << ",\n"
+        << "  \"decode_ms\": " << stats.decode_ms << ",\n"
+        << "  \"encode_ms\": " << stats.encode_ms << ",\n"
+        << "  \"identical\": " << (stats.identical ? "true" : "false") << ",\n"
+        << "  \"speedup\": " << stats.loop.median_ms / stats.packed.median_ms << ",\n";
+    write_packed_timing_json(out, "loop", stats.images, stats.loop);
+    out << ",\n";
+    write_packed_timing_json(out, "packed", stats.images, stats.packed);
+    write_arena_json(out, stats.packed.arena);
+    out << "\n}\n";
+    return (bool)out;
+}
+
+// Output name for an input: its stem, with _1, _2, ... for repeated stems (a/x.png and
+// b/x.png in a manifest, or one image listed many times), so no output overwrites another
+inline std::string unique_stem(const std::string &path, std::map<std::string, int> &stem_count) {
+    std::string stem = std::filesystem::path(path).stem().string();
+    if (int seen = stem_count[stem]++) {
+        stem += "_" + std::to_string(seen);
+    }
+    return stem;
+}
+
+// Runs process(input, output) on every image from source and writes <stem>.png
+// into out_dir (see unique_stem). Warm-up runs on the first image that loads; a failed
+// warm-up call fails that image like a failed timed call. Returns a process exit code.
+template <typename Process>
+int run_batch(const RunnerOptions &options, const std::string &pipeline,
+              const std::string &source, const std::string &out_dir, Process &&process) {
+    namespace fs = std::filesystem;
+    if (options.pack) {
+        std::cerr << pipeline << " has no batched generator; --pack is built for grayscale and blur\n";
+        return 1;
+    }
+    std::vector<std::string> paths = list_batch_inputs(source);
+    if (paths.empty()) {
+        std::cerr << "No input images found in " << source << "\n";
+        return 1;
+    }
+    fs::create_directories(out_dir);
+    std::cout << "Batch processing " << paths.size() << " images from " << source << "\n";
+
+    BatchStats stats;
+    // Output buffers of the most recently used sizes, most recent first: enough for both
+    // orientations of a photo set without growing with every distinct size. A size pushed
+    // out takes the pooled intermediates only it used with it.
+    struct SizeEntry {
+        std::pair<int, int> size;
+        Halide::Buffer<uint8_t> output;
+        uint64_t arena_mark;  // arena clock when this size was last processed
+    };
+    constexpr size_t kCachedSizes = 4;
+    std::list<SizeEntry> sizes;
+    std::map<std::string, int> stem_count;
+    bool warmed_up = false;
+    auto wall_start = BenchClock::now();
+
+    std::future<BatchImage> next = std::async(std::launch::async, decode_batch_image, paths[0]);
+    for (size_t i = 0; i < paths.size(); i++) {
+        BatchImage image = next.get();
+        // Named in input order, so a failed image does not shift the names of later ones
+        const std::string stem = unique_stem(image.path, stem_count);
+        if (i + 1 < paths.size()) {
+            next = std::async(std::launch::async, decode_batch_image, paths[i + 1]);
+        }
+        stats.decode_ms += image.decode_ms;
+        if (!image.loaded) {
+            std::cerr << "Failed to load input image: " << image.path << "\n";
+            stats.failed++;
+            continue;
+        }
+
+        const int width = image.pixels.width(), height = image.pixels.height();
+        Halide::Buffer<uint8_t> input = Halide::Buffer<uint8_t>::make_interleaved(image.pixels.data(), width, height, 3);
+        auto cached = std::find_if(sizes.begin(), sizes.end(), [&](const SizeEntry &entry) {
+            return entry.size == std::make_pair(width, height);
+        });
+        if (cached != sizes.end()) {
+            sizes.splice(sizes.begin(), sizes, cached);
+        } else {
+            if (sizes.size() == kCachedSizes) {
+                // Blocks last used before every kept size's latest call belong to the evicted one
+                sizes.pop_back();
+                uint64_t mark = HalideArena::instance().now();
+                for (const SizeEntry &entry : sizes) {
+                    mark = std::min(mark, entry.arena_mark);
+                }
+                HalideArena::instance().trim_unused_since(mark);
+            }
+            sizes.push_front({{width, height},
+                              Halide::Buffer<uint8_t>::make_interleaved(width, height, options.output_channels), 0});
+            stats.buffer_allocations++;
+        }
+        sizes.front().arena_mark = HalideArena::instance().now();
+        Halide::Buffer<uint8_t> &output = sizes.front().output;
+
+        // Warm up on the first image that loaded, whichever that is
+        int result = 0;
+        if (!warmed_up) {
+            warmed_up = true;
+            for (int w = 0; w < options.warmup && result == 0; w++) {
+                result = process(input, output);
+            }
+        }
+        auto compute_start = BenchClock::now();
+        if (result == 0) {
+            result = process(input, output);
+        }
+        stats.compute_ms += elapsed_ms(compute_start);
+        image.pixels = LoadedImage();
+        if (result != 0) {
+            std::cerr << "Pipeline failed on " << image.path << "\n";
+            stats.failed++;
+            continue;
+        }
+
+        auto encode_start = BenchClock::now();
+        std::string out_path = (fs::path(out_dir) / stem).string() + ".png";
+        if (!save_image(out_path, output)) {
+            std::cerr << "Failed to save output image: " << out_path << "\n";
+            stats.failed++;
+            continue;
+        }
+        stats.encode_ms += elapsed_ms(encode_start);
+        stats.images++;
+        stats.megapixels += width * (double)height / 1e6;
+    }
+    stats.wall_ms = elapsed_ms(wall_start);
+    stats.arena = HalideArena::instance().stats();
+
+    print_batch_stats(std::cout, stats);
+    if (!options.stats_path.empty() && !write_batch_stats_json(options.stats_path, pipeline, stats)) {
+        return 1;
+    }
+    return stats.failed ? 1 : 0;
+}
+
+// A dense (x, y, c, n) buffer of count images, each interleaved like the runners' buffers
+inline Halide::Buffer<uint8_t> make_packed(int width, int height, int channels, int count) {
+    return Halide::Buffer<uint8_t>({width, height, channels, count}, {2, 0, 1, 3});
+}
+
+// --batch --pack: decodes every image from source (cut into options.tile_width x
+// options.tile_height tiles if set), groups them by size and times process_packed(input,
+// output) once per group against process(input, output) once per image. The packed
+// outputs are written to out_dir as <stem>.png (<stem>_<row>_<col>.png for tiles).
+// Returns a process exit code.
+template <typename Process, typename ProcessPacked>
+int run_packed_batch(const RunnerOptions &options, const std::string &pipeline, const std::string &source,
+                     const std::string &out_dir, Process &&process, ProcessPacked &&process_packed) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths = list_batch_inputs(source);
+    if (paths.empty()) {
+        std::cerr << "No input images found in " << source << "\n";
+        return 1;
+    }
+    fs::create_directories(out_dir);
+
+    PackedStats stats;
+    stats.tile_width = options.tile_width;
+    stats.tile_height = options.tile_height;
+    std::vector<LoadedImage> images(paths.size());
+    struct Item {
+        size_t image;
+        int x, y, width, height;
+        std::string name;
+    };
+    std::vector<Item> items;
+    std::map<std::string, int> stem_count;
+    for (size_t i = 0; i < paths.size(); i++) {
+        auto start = BenchClock::now();
+        bool loaded = images[i].load(paths[i]);
+        stats.decode_ms += elapsed_ms(start);
+        if (!loaded) {
+            std::cerr << "Failed to load input image: " << paths[i] << "\n";
+            return 1;
+        }
+        std::string stem = unique_stem(paths[i], stem_count);
+        const int width = images[i].width(), height = images[i].height();
+        if (options.tile_width <= 0) {
+            items.push_back({i, 0, 0, width, height, stem});
+            continue;
+        }
+        for (int y = 0; y + options.tile_height <= height; y += options.tile_height) {
+            for (int x = 0; x + options.tile_width <= width; x += options.tile_width) {
+                items.push_back({i, x, y, options.tile_width, options.tile_height,
+                                 stem + "_" + std::to_string(y / options.tile_height) + "_" +
+                                     std::to_string(x / options.tile_width)});
+            }
+        }
+    }
+    if (items.empty()) {
+        std::cerr << "No image is at least " << options.tile_width << "x" << options.tile_height << "\n";
+        return 1;
+    }
+
+    // One packed input and two outputs (per-image calls, packed calls) per size
+    struct Group {
+        std::vector<size_t> items;
+        Halide::Buffer<uint8_t> input, loop_output, packed_output;
+        std::vector<Halide::Buffer<uint8_t>> inputs, loop_outputs;  // per-image slices
+    };
+    std::map<std::pair<int, int>, Group> groups;
+    for (size_t i = 0; i < items.size(); i++) {
+        groups[{items[i].width, items[i].height}].items.push_back(i);
+    }
+    for (auto &[size, group] : groups) {
+        const int count = (int)group.items.size();
+        group.input = make_packed(size.first, size.second, 3, count);
+        group.loop_output = make_packed(size.first, size.second, options.output_channels, count);
+        group.packed_output = make_packed(size.first, size.second, options.output_channels, count);
+        for (int n = 0; n < count; n++) {
+            const Item &item = items[group.items[n]];
+            const LoadedImage &image = images[item.image];
+            Halide::Buffer<uint8_t> tile = Halide::Buffer<uint8_t>::make_interleaved(image.data(), image.width(), image.height(), 3)
+                                               .cropped(0, item.x, item.width)
+                                               .cropped(1, item.y, item.height);
+            tile.set_min(0, 0);
+            group.inputs.push_back(group.input.sliced(3, n));
+            group.inputs.back().copy_from(tile);
+            group.loop_outputs.push_back(group.loop_output.sliced(3, n));
+        }
+        stats.megapixels += count * (double)size.first * size.second / 1e6;
+    }
+    images.clear();
+    stats.images = (int)items.size();
+    stats.groups = (int)groups.size();
+    std::cout << "Packed " << stats.images << " images from " << source << " into " << stats.groups
+              << " buffers\n";
+
+    int result = run_benchmark(options, stats.loop, [&] {
+        for (auto &entry : groups) {
+            Group &group = entry.second;
+            for (size_t n = 0; n < group.inputs.size(); n++) {
+                if (int error = process(group.inputs[n], group.loop_outputs[n])) return error;
+            }
+        }
+        return 0;
+    });
+    if (result == 0) {
+        result = run_benchmark(options, stats.packed, [&] {
+            for (auto &entry : groups) {
+                if (int error = process_packed(entry.second.input, entry.second.packed_output)) return error;
+            }
+            return 0;
+        });
+    }
+    if (result != 0) {
+        std::cerr << "Pipeline failed\n";
+        return 1;
+    }
+    for (BenchStats *timing : {&stats.loop, &stats.packed}) {
+        timing->mpix_per_s = stats.megapixels * 1000.0 / timing->median_ms;
+    }
+
+    stats.identical = true;
+    for (auto &entry : groups) {
+        const Group &group = entry.second;
+        stats.identical = stats.identical && std::memcmp(group.loop_output.data(), group.packed_output.data(),
+                                                         group.packed_output.size_in_bytes()) == 0;
+    }
+
+    auto encode_start = BenchClock::now();
+    int failed = 0;
+    for (auto &entry : groups) {
+        Group &group = entry.second;
+        for (size_t n = 0; n < group.items.size(); n++) {
+            std::string out_path = (fs::path(out_dir) / items[group.items[n]].name).string() + ".png";
+            if (!save_image(out_path, group.packed_output.sliced(3, (int)n))) {
+                std::cerr << "Failed to save output image: " << out_path << "\n";
+                failed++;
+            }
+        }
+    }
+    stats.encode_ms = elapsed_ms(encode_start);
+
+    print_packed_stats(std::cout, stats);
+    if (!options.stats_path.empty() && !write_packed_stats_json(options.stats_path, pipeline, stats)) {
+        return 1;
+    }
+    return failed || !stats.identical ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+// halide_bench.h
+// Timing harness for the Halide example runners: warm-up runs, N timed runs,
+// min/median/p95 statistics and a JSON dump that scripts/bench-halide.mjs
+// merges into the example's result.json. Image decode and encode are timed
+// separately so they never leak into the pipeline numbers.
+//
+// The driver's scaling sweep sets HL_NUM_THREADS per run and passes --size to time
+// the same image at other resolutions; both are recorded in the stats, as are the
+// Halide arena's peak memory and allocation counts (halide_arena.h).
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "halide_arena.h"
+#include "runner_options.h"
+
+using BenchClock = std::chrono::steady_clock;
+
+inline double elapsed_ms(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+// Number of worker threads; honours HL_NUM_THREADS like the Halide runtime
+inline int host_thread_count() {
+    const char *env = std::getenv("HL_NUM_THREADS");
+    int n = env ? std::atoi(env) : (int)std::thread::hardware_concurrency();
+    return std::max(n, 1);
+}
+
+// For --size: mirror-tiles interleaved RGB pixels to options.size_width x size_height so
+// stencils see no seams, and updates width and height. Empty if no size was requested.
+inline std::vector<uint8_t> tile_to_size(const RunnerOptions &options, const uint8_t *pixels, int &width, int &height) {
+    if (options.size_width <= 0) {
+        return {};
+    }
+    auto mirror = [](int i, int n) {
+        i %= 2 * n;
+        return i < n ? i : 2 * n - 1 - i;
+    };
+    std::vector<uint8_t> tiled((size_t)options.size_width * options.size_height * 3);
+    for (int y = 0; y < options.size_height; y++) {
+        const uint8_t *src = pixels + (size_t)mirror(y, height) * width * 3;
+        uint8_t *dst = tiled.data() + (size_t)y * options.size_width * 3;
+        for (int x = 0; x < options.size_width; x++) {
+            std::memcpy(dst + x * 3, src + mirror(x, width) * 3, 3);
+        }
+    }
+    width = options.size_width;
+    height = options.size_height;
+    return tiled;
+}
+
+struct BenchStats {
+    std::string isa;  // CPU variant the multitarget dispatch selected
+    int threads = 0;  // Halide thread pool size (HL_NUM_THREADS or the core count)
+    int width = 0;
+    int height = 0;
+    int warmup = 0;
+    int iterations = 0;
+    double min_ms = 0;
+    double median_ms = 0;
+    double p95_ms = 0;
+    double mean_ms = 0;
+    double mpix_per_s = 0;  // based on the median run
+    double decode_ms = 0;
+    double encode_ms = 0;
+    ArenaStats arena;       // counters cover the timed runs only
+    bool compared = false;  // set when --reference was checked
+    double mismatch = 0;
+    double psnr = 0;
+};
+
+// Nearest-rank percentile of already sorted samples
+inline double percentile(const std::vector<double> &sorted, double p) {
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+inline void summarize(std::vector<double> samples, BenchStats &stats) {
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double s : samples) {
+        total += s;
+    }
+    stats.iterations = (int)samples.size();
+    stats.min_ms = samples.front();
+    stats.median_ms = samples.size() % 2 ? samples[samples.size() / 2]
+                                         : 0.5 * (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]);
+    stats.p95_ms = percentile(samples, 0.95);
+    stats.mean_ms = total / samples.size();
+    stats.mpix_per_s = stats.median_ms > 0 ? (double)stats.width * stats.height / (stats.median_ms * 1000.0) : 0;
+}
+
+// Calls run() options.warmup times untimed, then options.iterations times timed.
+// run returns the Halide error code; the first non-zero code aborts and is returned.
+template <typename Run>
+int run_benchmark(const RunnerOptions &options, BenchStats &stats, Run &&run) {
+    for (int i = 0; i < options.warmup; i++) {
+        if (int error = run()) return error;
+    }
+    std::vector<double> samples;
+    ArenaStats arena_before = HalideArena::instance().stats();
+    for (int i = 0; i < options.iterations; i++) {
+        auto start = BenchClock::now();
+        if (int error = run()) return error;
+        samples.push_back(elapsed_ms(start));
+    }
+    stats.arena = arena_stats_since(arena_before, HalideArena::instance().stats());
+    stats.warmup = options.warmup;
+    stats.threads = host_thread_count();
+    summarize(samples, stats);
+    return 0;
+}
+
+inline void print_stats(std::ostream &os, const BenchStats &stats) {
+    os << std::fixed << std::setprecision(3)
+       << "Pipeline time: min " << stats.min_ms << " ms, median " << stats.median_ms
+       << " ms, p95 " << stats.p95_ms << " ms (" << stats.iterations << " runs, "
+       << stats.warmup << " warm-up, " << stats.threads << " threads)\n"
+       << "Throughput: " << std::setprecision(1) << stats.mpix_per_s << " MP/s\n"
+       << std::defaultfloat;
+    print_arena_stats(os, stats.arena);
+}
+
+// Decode and encode happen outside the timed runs; reported next to them so codec cost
+// is visible without skewing the pipeline numbers
+inline void print_io_stats(std::ostream &os, const BenchStats &stats) {
+    os << std::fixed << std::setprecision(2)
+       << "I/O: decode " << stats.decode_ms << " ms, encode " << stats.encode_ms << " ms\n"
+       << std::defaultfloat;
+}
+
+inline bool write_stats_json(const std::string &path, const std::string &pipeline, const BenchStats &stats) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write stats: " << path << "\n";
+        return false;
+    }
+    out << std::fixed << std::setprecision(4)
+        << "{\n"
+        << "  \"pipeline\": \"" << pipeline << "\",\n"
+        << "  \"isa\": \"" << stats.isa << "\",\n"
+        << "  \"threads\": " << stats.threads << ",\n"
+        << "  \"width\": " << stats.width << ",\n"
+        << "  \"height\": " << stats.height << ",\n"
+        << "  \"warmup\": " << stats.warmup << ",\n"
+        << "  \"iterations\": " << stats.iterations << ",\n"
+        << "  \"min_ms\": " << stats.min_ms << ",\n"
+        << "  \"median_ms\": " << stats.median_ms << ",\n"
+        << "  \"p95_ms\": " << stats.p95_ms << ",\n"
+        << "  \"mean_ms\": " << stats.mean_ms << ",\n"
+        << "  \"mpix_per_s\": " << stats.mpix_per_s << ",\n"
+        << "  \"decode_ms\": " << stats.decode_ms << ",\n"
+        << "  \"encode_ms\": " << stats.encode_ms;
+    write_arena_json(out, stats.arena);
+    if (stats.compared) {
+        out << ",\n  \"mismatch\": " << stats.mismatch << ",\n"
+            << "  \"psnr\": " << stats.psnr;
+    }
+    out << "\n}\n";
+    return (bool)out;
+}
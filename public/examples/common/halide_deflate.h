@@ -0,0 +1,105 @@
+// halide_deflate.h
+// Multi-threaded zlib compression for stb_image_write's PNG encoder, which otherwise
+// deflates the whole image on one thread and takes far longer than most pipelines.
+// The filtered scanlines are split into chunks compressed on worker threads, as pigz
+// does: each chunk is raw deflate primed with the previous 32 KiB as its dictionary and
+// ended with a sync flush, so the pieces concatenate into one ordinary zlib stream and
+// their Adler-32 checksums combine. The PNG is readable by any decoder. Needs zlib (-lz).
+//
+// Include before stb_image_write.h with STB_IMAGE_WRITE_IMPLEMENTATION.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#include "halide_bench.h"
+
+// Same contract as stbi_zlib_compress: a malloc'd zlib stream, or null on failure
+inline unsigned char *halide_zlib_compress(unsigned char *data, int data_len, int *out_len, int quality) {
+    const size_t chunk_bytes = 1 << 20;
+    const size_t window_bytes = 32768;
+    const size_t length = (size_t)data_len;
+    const size_t chunks = std::max<size_t>(1, (length + chunk_bytes - 1) / chunk_bytes);
+    const int level = std::min(std::max(quality, 1), 9);
+
+    std::vector<std::vector<unsigned char>> pieces(chunks);
+    std::vector<uLong> checksums(chunks);
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto compress_chunks = [&] {
+        for (size_t i; (i = next++) < chunks;) {
+            const size_t begin = i * chunk_bytes;
+            const size_t size = std::min(chunk_bytes, length - begin);
+            const bool last = i + 1 == chunks;
+            z_stream stream{};
+            if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                failed = true;
+                return;
+            }
+            if (begin > 0) {
+                const size_t dictionary = std::min(window_bytes, begin);
+                deflateSetDictionary(&stream, data + begin - dictionary, (uInt)dictionary);
+            }
+            // The bound covers a finished stream; a sync flush adds at most an empty stored block
+            pieces[i].resize(deflateBound(&stream, (uLong)size) + 16);
+            stream.next_in = data + begin;
+            stream.avail_in = (uInt)size;
+            stream.next_out = pieces[i].data();
+            stream.avail_out = (uInt)pieces[i].size();
+            int status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+            if ((last ? status != Z_STREAM_END : status != Z_OK) || stream.avail_in != 0 || stream.avail_out == 0) {
+                failed = true;
+            }
+            pieces[i].resize(stream.total_out);
+            deflateEnd(&stream);
+            checksums[i] = adler32(adler32(0L, Z_NULL, 0), data + begin, (uInt)size);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const size_t threads = std::min<size_t>(chunks, (size_t)host_thread_count());
+    for (size_t t = 1; t < threads; t++) {
+        workers.emplace_back(compress_chunks);
+    }
+    compress_chunks();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (failed) {
+        return nullptr;
+    }
+
+    uLong checksum = checksums[0];
+    size_t total = 2 + 4;
+    for (size_t i = 0; i < chunks; i++) {
+        if (i > 0) {
+            const size_t size = std::min(chunk_bytes, length - i * chunk_bytes);
+            checksum = adler32_combine(checksum, checksums[i], (z_off_t)size);
+        }
+        total += pieces[i].size();
+    }
+    unsigned char *out = (unsigned char *)std::malloc(total);
+    if (!out) {
+        return nullptr;
+    }
+    // zlib header: deflate with a 32 KiB window, default-level flag, no preset dictionary
+    unsigned char *p = out;
+    *p++ = 0x78;
+    *p++ = 0x9c;
+    for (const auto &piece : pieces) {
+        std::memcpy(p, piece.data(), piece.size());
+        p += piece.size();
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        *p++ = (unsigned char)(checksum >> shift);
+    }
+    *out_len = (int)total;
+    return out;
+}
+
+#define STBIW_ZLIB_COMPRESS halide_zlib_compress
@@ -0,0 +1,76 @@
+// halide_dispatch.h
+// Runtime CPU dispatch for the multi-target AOT builds.
+//
+// scripts/build-halide.sh compiles every generator for AVX-512, AVX2 and SSE4.1 into one
+// library (target=<avx512>,<avx2>,<sse41>). Halide's multitarget wrapper picks the first
+// variant whose features CPUID reports. --isa caps that choice so each variant can be
+// timed on a host that supports more.
+#pragma once
+
+#include <HalideRuntime.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+inline int g_isa_cap = 3;  // 1 = sse41, 2 = avx2, 3 = avx512
+
+inline int isa_level(const std::string &name) {
+    if (name == "sse41") return 1;
+    if (name == "avx2") return 2;
+    if (name == "avx512") return 3;
+    return 0;
+}
+
+inline const char *isa_name(int level) {
+    static const char *names[] = {"none", "sse41", "avx2", "avx512"};
+    return names[level];
+}
+
+// Highest variant the dispatcher will select on this host under the current cap
+inline int native_isa_level() {
+#if defined(__x86_64__) || defined(_M_X64)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd") &&
+        __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") &&
+        __builtin_cpu_supports("avx512vl")) {
+        return 3;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return 2;
+    }
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+inline int capped_can_use_target_features(int count, const uint64_t *features) {
+    auto has = [&](halide_target_feature_t f) {
+        return (int)f / 64 < count && ((features[f / 64] >> (f % 64)) & 1);
+    };
+    if (g_isa_cap < 3 && (has(halide_target_feature_avx512) || has(halide_target_feature_avx512_skylake))) {
+        return 0;
+    }
+    if (g_isa_cap < 2 && (has(halide_target_feature_avx2) || has(halide_target_feature_fma))) {
+        return 0;
+    }
+    return halide_default_can_use_target_features(count, features);
+}
+
+// Installs the cap for a non-empty --isa value. Returns the effective variant name
+// (the lower of the cap and what the CPU supports), or nullptr for an unknown name.
+inline const char *select_isa(const std::string &requested) {
+    int native = native_isa_level();
+    if (requested.empty()) {
+        return isa_name(native);
+    }
+    int level = isa_level(requested);
+    if (level == 0) {
+        std::cerr << "Unknown --isa " << requested << " (expected sse41, avx2 or avx512)\n";
+        return nullptr;
+    }
+    g_isa_cap = level;
+    halide_set_custom_can_use_target_features(capped_can_use_target_features);
+    return isa_name(std::min(level, native));
+}
@@ -0,0 +1,201 @@
+// halide_image_io.h
+// Image loading and saving for the Halide example runners. PNG and JPEG go through stb,
+// with PNG deflate spread over worker threads when halide_deflate.h was included ahead of
+// stb_image_write.h. Binary PPM skips decoding: an 8-bit P6 input is memory-mapped and
+// handed to the pipeline in place. Outputs ending in .ppm/.pgm are written uncompressed
+// (in one call when the channels match the extension), and .raw writes the bare
+// interleaved pixels, so benchmarks can take codec time out of the picture. Runners
+// report decode and encode time separately from the pipeline time.
+//
+// Include after stb_image.h and stb_image_write.h.
+#pragma once
+
+#include <Halide.h>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Interleaved RGB pixels of a loaded image; frees or unmaps them when destroyed
+class LoadedImage {
+public:
+    LoadedImage() = default;
+    LoadedImage(const LoadedImage &) = delete;
+    LoadedImage &operator=(const LoadedImage &) = delete;
+    LoadedImage(LoadedImage &&other) noexcept { swap(other); }
+    LoadedImage &operator=(LoadedImage &&other) noexcept {
+        swap(other);
+        return *this;
+    }
+    ~LoadedImage() { release(); }
+
+    // Maps 8-bit binary PPM in place and decodes anything else with stb
+    bool load(const std::string &path) {
+        release();
+        return map_ppm(path) || decode(path);
+    }
+
+    uint8_t *data() const { return data_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int channels() const { return channels_; }  // in the file; data() is always RGB
+    bool mapped() const { return map_ != nullptr; }
+
+private:
+    bool decode(const std::string &path) {
+        data_ = stbi_load(path.c_str(), &width_, &height_, &channels_, 3);
+        return data_ != nullptr;
+    }
+
+    bool map_ppm(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        void *map = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 2) {
+            // Private and writable so the pages behave like an ordinary buffer (copy on write)
+            map = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        const uint8_t *bytes = (const uint8_t *)map;
+        const size_t size = (size_t)info.st_size;
+        size_t pos = 2;
+        int fields[3] = {0, 0, 0};  // width, height, maxval
+        bool valid = bytes[0] == 'P' && bytes[1] == '6';
+        for (int f = 0; valid && f < 3; f++) {
+            // Skip whitespace and '#' comments, then read a decimal field
+            while (pos < size && (std::isspace(bytes[pos]) || bytes[pos] == '#')) {
+                if (bytes[pos] == '#') {
+                    while (pos < size && bytes[pos] != '\n') pos++;
+                } else {
+                    pos++;
+                }
+            }
+            valid = pos < size && std::isdigit(bytes[pos]);
+            while (valid && pos < size && std::isdigit(bytes[pos]) && fields[f] < (1 << 24)) {
+                fields[f] = fields[f] * 10 + (bytes[pos++] - '0');
+            }
+        }
+        pos++;  // single whitespace before the pixel data
+        valid = valid && fields[0] > 0 && fields[1] > 0 && fields[2] == 255 &&
+                pos + (size_t)fields[0] * fields[1] * 3 <= size;
+        if (!valid) {
+            munmap(map, size);
+            return false;
+        }
+        map_ = map;
+        map_size_ = size;
+        data_ = (uint8_t *)map + pos;
+        width_ = fields[0];
+        height_ = fields[1];
+        channels_ = 3;
+        return true;
+    }
+
+    void release() {
+        if (map_) {
+            munmap(map_, map_size_);
+        } else if (data_) {
+            stbi_image_free(data_);
+        }
+        map_ = nullptr;
+        data_ = nullptr;
+    }
+
+    void swap(LoadedImage &other) {
+        std::swap(data_, other.data_);
+        std::swap(map_, other.map_);
+        std::swap(map_size_, other.map_size_);
+        std::swap(width_, other.width_);
+        std::swap(height_, other.height_);
+        std::swap(channels_, other.channels_);
+    }
+
+    uint8_t *data_ = nullptr;
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    int channels_ = 0;
+};
+
+inline bool has_extension(const std::string &path, const char *ext) {
+    size_t n = std::char_traits<char>::length(ext);
+    return path.size() > n && path.compare(path.size() - n, n, ext) == 0;
+}
+
+// Binary PNM with the magic the extension promises: .pgm is always P5 and .ppm always P6.
+// A 3-channel image saved as .pgm is reduced to luma (the runners' 77/150/29 weights) and a
+// 1-channel one saved as .ppm is replicated to RGB, row by row.
+inline bool save_pnm(const std::string &path, const Halide::Buffer<uint8_t> &image) {
+    const int width = image.width(), height = image.height(), channels = image.channels();
+    const int row_bytes = image.dim(1).stride();
+    const int out_channels = has_extension(path, ".pgm") ? 1 : 3;
+    if (channels != 1 && channels != 3) {
+        std::cerr << "PPM/PGM output needs 1 or 3 channels, not " << channels << "\n";
+        return false;
+    }
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "%s\n%d %d\n255\n", out_channels == 1 ? "P5" : "P6", width, height);
+    bool ok = true;
+    if (channels == out_channels) {
+        // Runner outputs are dense, so the pixels go out in one write
+        const size_t bytes = (size_t)row_bytes * height;
+        ok = std::fwrite(image.data(), 1, bytes, file) == bytes;
+    } else {
+        std::vector<uint8_t> row((size_t)width * out_channels);
+        for (int y = 0; y < height && ok; y++) {
+            const uint8_t *in = image.data() + (size_t)y * row_bytes;
+            for (int x = 0; x < width; x++) {
+                if (out_channels == 1) {
+                    row[x] = (uint8_t)((77 * in[3 * x] + 150 * in[3 * x + 1] + 29 * in[3 * x + 2] + 128) >> 8);
+                } else {
+                    row[3 * x] = row[3 * x + 1] = row[3 * x + 2] = in[x];
+                }
+            }
+            ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+        }
+    }
+    return std::fclose(file) == 0 && ok;
+}
+
+// Writes an interleaved 1- or 3-channel buffer; the format follows the extension
+inline bool save_image(const std::string &path, const Halide::Buffer<uint8_t> &image) {
+    const int width = image.width(), height = image.height(), channels = image.channels();
+    const int row_bytes = image.dim(1).stride();
+    if (has_extension(path, ".png")) {
+        return stbi_write_png(path.c_str(), width, height, channels, image.data(), row_bytes);
+    }
+    if (has_extension(path, ".jpg") || has_extension(path, ".jpeg")) {
+        return stbi_write_jpg(path.c_str(), width, height, channels, image.data(), 95);
+    }
+    if (has_extension(path, ".ppm") || has_extension(path, ".pgm")) {
+        return save_pnm(path, image);
+    }
+    if (has_extension(path, ".raw")) {
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        const size_t bytes = (size_t)row_bytes * height;
+        bool ok = std::fwrite(image.data(), 1, bytes, file) == bytes;
+        return std::fclose(file) == 0 && ok;
+    }
+    std::cerr << "Unsupported output format. Use .png, .jpg, .ppm, .pgm or .raw\n";
+    return false;
+}
@@ -0,0 +1,274 @@
+// halide_jit.h
+// JIT builds of the runners (<op>_runner.jit). Instead of linking AOT libraries, the
+// runner is linked with the example's generator, libHalide and one shared Halide runtime,
+// and compiles each pipeline the first time it is called: the generator is run in-process
+// for the host (HL_JIT_TARGET overrides it) with the generator params from HL_JIT_PARAMS,
+// the object is linked into a shared library and loaded with dlopen. The library is kept
+// in an on-disk cache (HL_JIT_CACHE, default halide_build/jit-cache) under a hash of the
+// generator source, generator name, params (estimates included), target and Halide
+// version, so any later run of the same configuration skips LLVM and only pays dlopen.
+//
+// build-halide.sh writes <name>_aot.h for these builds, defining <name>(args...) to call
+// through jit_pipeline(); runners are unchanged.
+//
+//   HL_JIT_PARAMS="estimate_width=640 estimate_height=480 autoscheduler=Adams2019"
+//
+// Each generator gets only the params it declares, so one runner's pipelines can share
+// HL_JIT_PARAMS. HL_JIT_TARGET may add CPU features but must stay on the host OS and
+// architecture without GPU features: the runner links a single host runtime.
+//
+// Params a runner mirrors at compile time (HL_PARAM_<name>, e.g. output_channels) still
+// need a runner built with them.
+#pragma once
+
+#include <Halide.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+// Defined by build-halide.sh for JIT builds
+#ifndef HL_JIT_SOURCE_HASH
+#define HL_JIT_SOURCE_HASH "unknown"
+#endif
+#ifndef HL_JIT_CACHE_DIR
+#define HL_JIT_CACHE_DIR "halide_build/jit-cache"
+#endif
+#ifndef HL_JIT_PLUGIN_DIR
+#define HL_JIT_PLUGIN_DIR ""
+#endif
+#ifndef HL_JIT_CXX
+#define HL_JIT_CXX "c++"
+#endif
+
+// "k=v k=v" from HL_JIT_PARAMS
+inline std::map<std::string, std::string> jit_params_from_environment() {
+    std::map<std::string, std::string> params;
+    const char *env = std::getenv("HL_JIT_PARAMS");
+    std::istringstream in(env ? env : "");
+    std::string entry;
+    while (in >> entry) {
+        size_t eq = entry.find('=');
+        if (eq != std::string::npos) {
+            params[entry.substr(0, eq)] = entry.substr(eq + 1);
+        } else {
+            std::cerr << "Ignoring HL_JIT_PARAMS entry without '=': " << entry << "\n";
+        }
+    }
+    return params;
+}
+
+// FNV-1a; the key only has to tell configurations apart, not resist collisions on purpose
+inline uint64_t jit_hash(const std::string &text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline std::string shell_quote(const std::string &text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+}
+
+// The host target the JIT compiles for, or an error if the runner's runtime cannot run its
+// pipelines: the runner links one runtime built for the host, without GPU modules
+inline bool jit_target(Halide::Target &target) {
+    target = Halide::get_jit_target_from_environment()
+                 .without_feature(Halide::Target::JIT)
+                 .with_feature(Halide::Target::NoRuntime);
+    const Halide::Target host = Halide::get_host_target();
+    if (target.os != host.os || target.arch != host.arch || target.bits != host.bits) {
+        std::cerr << "JIT target " << target.to_string() << " is not the host (" << host.to_string()
+                  << "); the runner's runtime only runs host pipelines\n";
+        return false;
+    }
+    if (target.has_gpu_feature()) {
+        std::cerr << "JIT target " << target.to_string()
+                  << " needs a GPU runtime the runner does not link; drop the GPU feature from HL_JIT_TARGET\n";
+        return false;
+    }
+    return true;
+}
+
+// The HL_JIT_PARAMS entries generator <name> declares. The params are shared by every
+// pipeline in the runner, so one generator's params (e.g. estimate_batch) are skipped for
+// the others instead of failing them; autoscheduler settings apply to all of them.
+inline std::map<std::string, std::string> jit_declared_params(const std::string &name, const Halide::Target &target,
+                                                              const std::map<std::string, std::string> &params) {
+    std::map<std::string, std::string> declared;
+    auto generator = Halide::Internal::GeneratorRegistry::create(name, Halide::GeneratorContext(target));
+    for (const auto &[param, value] : params) {
+        if (param == "autoscheduler" || param.rfind("autoscheduler.", 0) == 0) {
+            declared[param] = value;
+            continue;
+        }
+        try {
+            generator->set_generatorparam_value(param, value);
+            declared[param] = value;
+        } catch (const Halide::Error &error) {
+            // A declared param with a bad value is still an error
+            if (std::string(error.what()).find("no GeneratorParam") == std::string::npos) {
+                throw;
+            }
+        }
+    }
+    return declared;
+}
+
+// One generator compiled (or loaded from the cache) for the JIT target. Any failure is
+// reported and leaves the pipeline unloaded, so calls return -1 like a failed AOT call.
+class JitPipeline {
+public:
+    JitPipeline(const std::string &name) {
+        try {
+            load(name);
+        } catch (const Halide::Error &error) {
+            std::cerr << "JIT " << name << ": " << error.what() << "\n";
+        } catch (const std::filesystem::filesystem_error &error) {
+            std::cerr << "JIT " << name << ": " << error.what() << "\n";
+        }
+    }
+
+    // Arguments as for the AOT function: buffers as halide_buffer_t *, scalars by value
+    template <typename... Args>
+    int operator()(Args... args) {
+        if (!function_) {
+            return -1;
+        }
+        void *argv[] = {argv_entry(args)...};
+        return function_(argv);
+    }
+
+private:
+    void load(const std::string &name) {
+        namespace fs = std::filesystem;
+        auto start = std::chrono::steady_clock::now();
+        Halide::Target target;
+        if (!jit_target(target)) {
+            return;
+        }
+        const std::map<std::string, std::string> params = jit_declared_params(name, target, jit_params_from_environment());
+
+        std::ostringstream key;
+        key << HL_JIT_SOURCE_HASH << "\n" << name << "\n" << target.to_string() << "\n"
+            << HALIDE_VERSION_MAJOR << "." << HALIDE_VERSION_MINOR << "." << HALIDE_VERSION_PATCH << "\n";
+        for (const auto &[param, value] : params) {
+            key << param << "=" << value << "\n";
+        }
+        std::ostringstream file;
+        file << name << "-" << std::hex << std::setw(16) << std::setfill('0') << jit_hash(key.str()) << ".so";
+
+        const char *env_dir = std::getenv("HL_JIT_CACHE");
+        const fs::path cache_dir = env_dir && *env_dir ? env_dir : HL_JIT_CACHE_DIR;
+        const fs::path library = cache_dir / file.str();
+        const bool hit = fs::exists(library);
+        if (!hit && !compile(name, target, params, cache_dir, library)) {
+            return;
+        }
+
+        // Runtime symbols resolve against the runner, which exports its one runtime
+        void *handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle) {
+            std::cerr << "Failed to load " << library.string() << ": " << dlerror() << "\n";
+            return;
+        }
+        handle_ = handle;
+        function_ = (int (*)(void **))dlsym(handle_, (name + "_argv").c_str());
+        if (!function_) {
+            std::cerr << "No " << name << "_argv in " << library.string() << "\n";
+            return;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "JIT " << name << ": " << (hit ? "cache hit, loaded" : "compiled") << " in " << std::fixed
+                  << std::setprecision(1) << ms << " ms (" << library.string() << ")\n"
+                  << std::defaultfloat;
+    }
+
+    // The _argv entry point takes buffers as themselves and scalars by address
+    static void *argv_entry(halide_buffer_t *&buffer) { return buffer; }
+    template <typename T>
+    static void *argv_entry(T &value) { return &value; }
+
+    // Runs the generator in-process and links the object into <library>; the library is
+    // renamed into place last, so concurrent runners never load a partial one
+    static bool compile(const std::string &name, const Halide::Target &target,
+                        const std::map<std::string, std::string> &params,
+                        const std::filesystem::path &cache_dir, const std::filesystem::path &library) {
+        namespace fs = std::filesystem;
+        const fs::path work = cache_dir / (library.stem().string() + ".tmp" + std::to_string(getpid()));
+        fs::create_directories(work);
+        // The work dir goes whether the generator, the link or the rename fails
+        struct RemoveWork {
+            fs::path path;
+            ~RemoveWork() {
+                std::error_code ignored;
+                fs::remove_all(path, ignored);
+            }
+        } remove_work{work};
+
+        auto scheduler = params.find("autoscheduler");
+        if (scheduler != params.end() && *HL_JIT_PLUGIN_DIR) {
+            std::string plugin = scheduler->second;
+            std::transform(plugin.begin(), plugin.end(), plugin.begin(), [](unsigned char c) { return std::tolower(c); });
+            Halide::load_plugin(std::string(HL_JIT_PLUGIN_DIR) + "/libautoschedule_" + plugin + ".so");
+        }
+
+        Halide::Internal::ExecuteGeneratorArgs args;
+        args.output_dir = work.string();
+        args.output_types = {Halide::OutputFileType::object};
+        args.targets = {target};
+        args.generator_name = name;
+        args.function_name = name;
+        args.file_base_name = name;
+        args.generator_params = Halide::GeneratorParamsMap(params.begin(), params.end());
+        args.create_generator = [](const std::string &generator, const Halide::GeneratorContext &context) {
+            return Halide::Internal::GeneratorRegistry::create(generator, context);
+        };
+        std::cout << "JIT " << name << ": compiling for " << target.to_string() << "...\n";
+        Halide::Internal::execute_generator(args);
+
+        const fs::path object = work / (name + ".o");
+        const fs::path partial = work / library.filename();
+        const std::string link = std::string(HL_JIT_CXX) + " -shared -o " + shell_quote(partial.string()) + " " +
+                                 shell_quote(object.string());
+        bool linked = std::system(link.c_str()) == 0;
+        if (linked) {
+            fs::rename(partial, library);
+        } else {
+            std::cerr << "Failed to link " << object.string() << " (" << link << ")\n";
+        }
+        return linked;
+    }
+
+    void *handle_ = nullptr;  // never closed: the runtime may still reference its code
+    int (*function_)(void **) = nullptr;
+};
+
+// The process-wide pipeline for a generator, compiled or loaded on first use
+inline JitPipeline &jit_pipeline(const std::string &name) {
+    static std::mutex mutex;
+    static std::map<std::string, JitPipeline *> pipelines;
+    std::lock_guard<std::mutex> lock(mutex);
+    JitPipeline *&pipeline = pipelines[name];
+    if (!pipeline) {
+        pipeline = new JitPipeline(name);
+    }
+    return *pipeline;
+}
@@ -0,0 +1,86 @@
+// halide_profile.h
+// Per-stage breakdown for runners built with Halide's sampling profiler
+// (<op>_runner.profile: built for the host target alone with feature "profile", since
+// the profiler registers a multitarget build per sub-pipeline; compiled with -DHL_PROFILER).
+// --profile FILE writes each Func's share of the pipeline time, its peak allocation and
+// the average number of active threads, next to host-side stages the runner times
+// itself (e.g. Canny's hysteresis). scripts/bench-halide.mjs copies the file to
+// public/examples/<op>/profile.json for the benchmark page.
+#pragma once
+
+#include <Halide.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "runner_options.h"
+
+// Host code run alongside the pipeline; total_ms is summed over every run
+struct HostStage {
+    std::string name;
+    double total_ms = 0;
+};
+
+inline bool write_profile_json(const std::string &path, const std::string &pipeline,
+                               const std::vector<HostStage> &host_stages = {}) {
+#ifndef HL_PROFILER
+    (void)path;
+    (void)pipeline;
+    (void)host_stages;
+    std::cerr << "This runner was built without the profiler; use <op>_runner.profile\n";
+    return false;
+#else
+    const halide_profiler_pipeline_stats *stats = halide_profiler_get_pipeline_state(pipeline.c_str());
+    if (!stats || stats->runs == 0) {
+        std::cerr << "No profile recorded for " << pipeline << "\n";
+        return false;
+    }
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write profile: " << path << "\n";
+        return false;
+    }
+
+    // Profiler times are nanoseconds summed over all runs (warm-up included)
+    const double runs = stats->runs;
+    auto threads = [](uint64_t numerator, uint64_t denominator) {
+        return denominator ? (double)numerator / denominator : 0.0;
+    };
+    out << std::fixed << std::setprecision(4)
+        << "{\n"
+        << "  \"pipeline\": \"" << pipeline << "\",\n"
+        << "  \"runs\": " << stats->runs << ",\n"
+        << "  \"total_ms\": " << stats->time / 1e6 / runs << ",\n"
+        << "  \"threads\": " << threads(stats->active_threads_numerator, stats->active_threads_denominator) << ",\n"
+        << "  \"memory_peak\": " << stats->memory_peak << ",\n"
+        << "  \"stages\": [";
+    const char *separator = "\n";
+    for (int i = 0; i < stats->num_funcs; i++) {
+        const halide_profiler_func_stats &func = stats->funcs[i];
+        if (func.time == 0 && func.memory_peak == 0) {
+            continue;
+        }
+        out << separator
+            << "    {\"name\": \"" << func.name << "\", "
+            << "\"ms\": " << func.time / 1e6 / runs << ", "
+            << "\"percent\": " << (stats->time ? 100.0 * func.time / stats->time : 0.0) << ", "
+            << "\"memory_peak\": " << func.memory_peak << ", "
+            << "\"allocs\": " << func.num_allocs << ", "
+            << "\"threads\": " << threads(func.active_threads_numerator, func.active_threads_denominator) << "}";
+        separator = ",\n";
+    }
+    out << "\n  ],\n"
+        << "  \"host\": [";
+    separator = "\n";
+    for (const HostStage &stage : host_stages) {
+        out << separator << "    {\"name\": \"" << stage.name << "\", \"ms\": " << stage.total_ms / runs << "}";
+        separator = ",\n";
+    }
+    out << "\n  ]\n"
+        << "}\n";
+    std::cout << "Wrote per-stage profile: " << path << "\n";
+    return (bool)out;
+#endif
+}
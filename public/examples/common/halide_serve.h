@@ -0,0 +1,311 @@
+// halide_serve.h
+// Frame-server mode for the Halide example runners (--serve WxH): one long-lived process
+// reads raw RGB24 frames of a fixed size, runs the pipeline on each and writes the raw
+// result frames back (8-bit gray for single-channel builds), for video or camera streams
+// at frame rate. Buffers are allocated once and the Halide thread pool stays warm between
+// frames. Input and output are double-buffered: frame N+1 is read and frame N-1 written
+// while frame N is processed.
+//
+// <input> is "-" (stdin), a file or FIFO, or unix:PATH to listen on a local socket and
+// answer each frame on the same connection. <output> is "-" (stdout, or the socket) or a
+// file or FIFO. Statistics go to stderr since stdout may carry frames.
+#pragma once
+
+#include <Halide.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <poll.h>
+#include <queue>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "halide_bench.h"
+
+struct ServeStats {
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    double wall_ms = 0;
+    std::vector<double> compute_ms;  // pipeline time per frame
+    std::vector<double> latency_ms;  // frame fully read -> result fully written
+    ArenaStats arena;
+};
+
+// Blocking hand-off of buffer slot indices between the reader, compute and writer threads
+class SlotQueue {
+public:
+    void push(int slot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_.push(slot);
+        }
+        ready_.notify_one();
+    }
+
+    int pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [&] { return !slots_.empty(); });
+        int slot = slots_.front();
+        slots_.pop();
+        return slot;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::queue<int> slots_;
+};
+
+// Reads exactly size bytes; returns false at end of stream, on error or once stop_fd
+// becomes readable (which wakes a read blocked on a pipe or socket)
+inline bool read_frame(int fd, uint8_t *data, size_t size, int stop_fd = -1) {
+    size_t done = 0;
+    while (done < size) {
+        if (stop_fd >= 0) {
+            pollfd fds[2] = {{fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (fds[1].revents) return false;
+        }
+        ssize_t n = read(fd, data + done, size - done);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            if (done > 0) std::cerr << "Stream ended inside a frame (" << done << " of " << size << " bytes)\n";
+            return false;
+        }
+        done += (size_t)n;
+    }
+    return true;
+}
+
+inline bool write_frame(int fd, const uint8_t *data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(fd, data + done, size - done);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Listens on a Unix domain socket and returns the first connection, or -1
+inline int accept_local_client(const std::string &path) {
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (server < 0 || path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Cannot create socket " << path << "\n";
+        return -1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(server, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 1) != 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        close(server);
+        return -1;
+    }
+    std::cerr << "Listening on " << path << "\n";
+    int client = accept(server, nullptr, nullptr);
+    close(server);
+    unlink(path.c_str());
+    return client;
+}
+
+inline void print_serve_stats(std::ostream &os, const ServeStats &stats) {
+    if (stats.frames == 0) {
+        os << "Served 0 frames\n";
+        return;
+    }
+    std::vector<double> compute = stats.compute_ms, latency = stats.latency_ms;
+    std::sort(compute.begin(), compute.end());
+    std::sort(latency.begin(), latency.end());
+    os << std::fixed << std::setprecision(2)
+       << "Served " << stats.frames << " frames of " << stats.width << "x" << stats.height << " at "
+       << stats.frames * 1000.0 / stats.wall_ms << " fps\n"
+       << "Compute: p50 " << percentile(compute, 0.5) << " ms, p95 " << percentile(compute, 0.95)
+       << " ms, p99 " << percentile(compute, 0.99) << " ms\n"
+       << "Latency: p50 " << percentile(latency, 0.5) << " ms, p95 " << percentile(latency, 0.95)
+       << " ms, p99 " << percentile(latency, 0.99) << " ms, max " << latency.back() << " ms\n"
+       << std::defaultfloat;
+    print_arena_stats(os, stats.arena);
+}
+
+inline bool write_serve_stats_json(const std::string &path, const std::string &pipeline, const ServeStats &stats) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write stats: " << path << "\n";
+        return false;
+    }
+    std::vector<double> compute = stats.compute_ms, latency = stats.latency_ms;
+    std::sort(compute.begin(), compute.end());
+    std::sort(latency.begin(), latency.end());
+    out << std::fixed << std::setprecision(4)
+        << "{\n"
+        << "  \"pipeline\": \"" << pipeline << "\",\n"
+        << "  \"mode\": \"serve\",\n"
+        << "  \"width\": " << stats.width << ",\n"
+        << "  \"height\": " << stats.height << ",\n"
+        << "  \"frames\": " << stats.frames << ",\n"
+        << "  \"wall_ms\": " << stats.wall_ms;
+    if (stats.frames > 0) {
+        out << ",\n  \"fps\": " << stats.frames * 1000.0 / stats.wall_ms << ",\n"
+            << "  \"compute_p50_ms\": " << percentile(compute, 0.5) << ",\n"
+            << "  \"compute_p95_ms\": " << percentile(compute, 0.95) << ",\n"
+            << "  \"compute_p99_ms\": " << percentile(compute, 0.99) << ",\n"
+            << "  \"latency_p50_ms\": " << percentile(latency, 0.5) << ",\n"
+            << "  \"latency_p95_ms\": " << percentile(latency, 0.95) << ",\n"
+            << "  \"latency_p99_ms\": " << percentile(latency, 0.99);
+    }
+    write_arena_json(out, stats.arena);
+    out << "\n}\n";
+    return (bool)out;
+}
+
+// Serves frames of options.serve_width x options.serve_height through process(input,
+// output) until the input stream ends. Returns a process exit code.
+template <typename Process>
+int run_server(const RunnerOptions &options, const std::string &pipeline,
+               const std::string &in_path, const std::string &out_path, Process &&process) {
+    using Halide::Buffer;
+    const int width = options.serve_width, height = options.serve_height;
+    const size_t frame_bytes = (size_t)width * height * 3;
+    const size_t result_bytes = (size_t)width * height * options.output_channels;
+
+    int in_fd, out_fd;
+    bool socket_mode = in_path.compare(0, 5, "unix:") == 0;
+    if (socket_mode) {
+        in_fd = out_fd = accept_local_client(in_path.substr(5));
+    } else {
+        in_fd = in_path == "-" ? STDIN_FILENO : open(in_path.c_str(), O_RDONLY);
+        out_fd = out_path == "-" ? STDOUT_FILENO : open(out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (in_fd < 0 || out_fd < 0) {
+        std::cerr << "Failed to open frame streams\n";
+        return 1;
+    }
+    // A reader that goes away shows up as a failed write, not a signal
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Buffer<uint8_t>> inputs, outputs;
+    for (int i = 0; i < 2; i++) {
+        inputs.push_back(Buffer<uint8_t>::make_interleaved(width, height, 3));
+        outputs.push_back(Buffer<uint8_t>::make_interleaved(width, height, options.output_channels));
+    }
+    // Spin up the thread pool and touch the buffers before the first frame
+    inputs[0].fill(0);
+    for (int i = 0; i < options.warmup; i++) {
+        if (process(inputs[0], outputs[0]) != 0) {
+            std::cerr << "Pipeline failed during warm-up\n";
+            return 1;
+        }
+    }
+
+    ServeStats stats;
+    stats.width = width;
+    stats.height = height;
+    BenchClock::time_point arrived[2];
+    SlotQueue free_inputs, filled_inputs, free_outputs, filled_outputs;
+    for (int i = 0; i < 2; i++) {
+        free_inputs.push(i);
+        free_outputs.push(i);
+    }
+    BenchClock::time_point output_arrived[2];  // arrival time of the frame in each output slot
+    std::atomic<bool> write_failed{false};
+    // Written once to stop the reader, which may be blocked on a live stream
+    int stop_pipe[2];
+    if (pipe(stop_pipe) != 0) {
+        std::cerr << "Failed to create stop pipe: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::cerr << "Serving " << width << "x" << height << " RGB frames (" << frame_bytes << " bytes each)\n";
+    auto wall_start = BenchClock::now();
+
+    std::thread reader([&] {
+        for (;;) {
+            int slot = free_inputs.pop();
+            if (slot < 0) return;
+            if (!read_frame(in_fd, inputs[slot].data(), frame_bytes, stop_pipe[0])) {
+                filled_inputs.push(-1);
+                return;
+            }
+            arrived[slot] = BenchClock::now();
+            filled_inputs.push(slot);
+        }
+    });
+    std::thread writer([&] {
+        for (;;) {
+            int slot = filled_outputs.pop();
+            if (slot < 0) return;
+            if (!write_failed && !write_frame(out_fd, outputs[slot].data(), result_bytes)) {
+                std::cerr << "Failed to write frame; the reader went away\n";
+                write_failed = true;
+            }
+            stats.latency_ms.push_back(elapsed_ms(output_arrived[slot]));
+            free_outputs.push(slot);
+        }
+    });
+
+    int result = 0;
+    for (;;) {
+        // Nobody reads the results any more once a write failed
+        if (write_failed) break;
+        int in_slot = filled_inputs.pop();
+        if (in_slot < 0) break;
+        int out_slot = free_outputs.pop();
+
+        auto compute_start = BenchClock::now();
+        result = process(inputs[in_slot], outputs[out_slot]);
+        stats.compute_ms.push_back(elapsed_ms(compute_start));
+        output_arrived[out_slot] = arrived[in_slot];
+        free_inputs.push(in_slot);
+        if (result != 0) {
+            std::cerr << "Pipeline failed on frame " << stats.frames << "\n";
+            free_outputs.push(out_slot);
+            break;
+        }
+        filled_outputs.push(out_slot);
+        stats.frames++;
+    }
+    filled_outputs.push(-1);
+    writer.join();
+    // Wake the reader wherever it waits (in read or for a free slot) and join it before
+    // the buffers and queues it uses go out of scope
+    const char stop = 0;
+    while (write(stop_pipe[1], &stop, 1) < 0 && errno == EINTR) {
+    }
+    free_inputs.push(-1);
+    reader.join();
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    stats.wall_ms = elapsed_ms(wall_start);
+    stats.arena = HalideArena::instance().stats();
+    if (socket_mode) {
+        close(in_fd);
+    }
+
+    print_serve_stats(std::cerr, stats);
+    if (!options.stats_path.empty() && !write_serve_stats_json(options.stats_path, pipeline, stats)) {
+        return 1;
+    }
+    return result != 0 || write_failed ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+// halide_size_classes.h
+// Size-class dispatch for the autoscheduled runners. build-halide.sh runs each generator
+// once per size class (HL_SIZE_CLASSES) with estimate_width/estimate_height set to the
+// class's frame size, so the autoscheduler tiles for that size, and links every build
+// into one runner. It then writes <name>_aot.h, which defines <name>(input, ...) to call
+// the build whose size is nearest the input's pixel count; runners are unchanged.
+#pragma once
+
+#include <HalideRuntime.h>
+#include <cmath>
+#include <cstddef>
+
+struct SizeClass {
+    const char *name;
+    int width;
+    int height;
+};
+
+// Index of the class nearest in pixel count on a log scale, so a frame between a
+// thumbnail and a 1080p class goes to whichever it is fewer times larger or smaller than
+template <size_t N>
+inline size_t nearest_size_class(const SizeClass (&classes)[N], const halide_buffer_t *input) {
+    const double pixels = (double)input->dim[0].extent * input->dim[1].extent;
+    size_t best = 0;
+    double best_distance = INFINITY;
+    for (size_t i = 0; i < N; i++) {
+        double distance = std::fabs(std::log(pixels / ((double)classes[i].width * classes[i].height)));
+        if (distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
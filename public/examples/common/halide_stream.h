@@ -0,0 +1,257 @@
+// halide_stream.h
+// Streaming mode for the Halide example runners (--stream): the input is read one strip
+// of rows at a time, the pipeline runs on each strip plus the halo rows its stencils
+// need, and finished rows are written out straight away. Memory is bounded by the strip
+// height instead of the image size, so gigapixel images fit in a few megabytes.
+//
+// stb_image has no incremental decoder or encoder, so streaming reads binary PPM (P6,
+// 8-bit) and writes PPM, or PGM (P5) for single-channel builds; convert other formats
+// first (e.g. `vips copy big.tif big.ppm`).
+#pragma once
+
+#include <Halide.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "halide_bench.h"
+
+struct StreamStats {
+    int width = 0;
+    int height = 0;
+    int strip_rows = 0;
+    int halo = 0;
+    int strips = 0;
+    size_t buffer_bytes = 0;  // strip buffers held at once
+    double wall_ms = 0;
+    double compute_ms = 0;
+    double read_ms = 0;
+    double write_ms = 0;
+    ArenaStats arena;
+};
+
+class PpmReader {
+public:
+    // Parses the P6 header; false if the file is missing or not 8-bit binary PPM
+    bool open(const std::string &path) {
+        in_.open(path, std::ios::binary);
+        std::string magic = token(), w = token(), h = token(), maxval = token();
+        if (!in_ || magic != "P6" || maxval != "255") {
+            std::cerr << "Streaming needs an 8-bit binary PPM (P6) input: " << path << "\n";
+            return false;
+        }
+        width_ = std::atoi(w.c_str());
+        height_ = std::atoi(h.c_str());
+        in_.get();  // single whitespace before the pixel data
+        return width_ > 0 && height_ > 0;
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    bool read_rows(uint8_t *dst, int rows) {
+        return (bool)in_.read((char *)dst, (std::streamsize)rows * width_ * 3);
+    }
+
+private:
+    // Next header token, skipping whitespace and '#' comments
+    std::string token() {
+        std::string t;
+        int ch;
+        while ((ch = in_.get()) != EOF) {
+            if (ch == '#') {
+                while ((ch = in_.get()) != EOF && ch != '\n') {}
+            } else if (!std::isspace(ch)) {
+                t += (char)ch;
+                if (std::isspace(in_.peek()) || in_.peek() == '#') break;
+            }
+        }
+        return t;
+    }
+
+    std::ifstream in_;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+// Writes P6 for 3 channels and P5 (grayscale PGM) for 1; the extension must agree (.ppm
+// or .pgm), since rows are written as they come and are not converted
+class PpmWriter {
+public:
+    bool open(const std::string &path, int width, int height, int channels = 3) {
+        const bool pgm = path.size() > 4 && path.compare(path.size() - 4, 4, ".pgm") == 0;
+        if (pgm != (channels == 1)) {
+            std::cerr << (channels == 1 ? "Single-channel output streams to .pgm, not " : "RGB output streams to .ppm, not ")
+                      << path << "\n";
+            return false;
+        }
+        out_.open(path, std::ios::binary);
+        out_ << (channels == 1 ? "P5\n" : "P6\n") << width << " " << height << "\n255\n";
+        row_bytes_ = (size_t)width * channels;
+        return (bool)out_;
+    }
+
+    bool write_rows(const uint8_t *src, int rows) {
+        return (bool)out_.write((const char *)src, (std::streamsize)(rows * row_bytes_));
+    }
+
+private:
+    std::ofstream out_;
+    size_t row_bytes_ = 0;
+};
+
+inline bool is_ppm_path(const std::string &path) {
+    return path.size() > 4 && (path.compare(path.size() - 4, 4, ".ppm") == 0 ||
+                               path.compare(path.size() - 4, 4, ".pgm") == 0);
+}
+
+inline void print_stream_stats(std::ostream &os, const StreamStats &stats) {
+    double megapixels = stats.width * (double)stats.height / 1e6;
+    os << std::fixed << std::setprecision(2)
+       << "Stream: " << stats.width << "x" << stats.height << " in " << stats.strips << " strips of "
+       << stats.strip_rows << " rows (+" << stats.halo << " halo), "
+       << stats.buffer_bytes / (1024.0 * 1024.0) << " MiB of strip buffers\n"
+       << "Throughput: " << megapixels * 1000.0 / stats.wall_ms << " MP/s end-to-end, "
+       << megapixels * 1000.0 / stats.compute_ms << " MP/s compute\n"
+       << "Time: compute " << stats.compute_ms << " ms, read " << stats.read_ms
+       << " ms, write " << stats.write_ms << " ms\n"
+       << std::defaultfloat;
+    print_arena_stats(os, stats.arena);
+}
+
+inline bool write_stream_stats_json(const std::string &path, const std::string &pipeline, const StreamStats &stats) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write stats: " << path << "\n";
+        return false;
+    }
+    double megapixels = stats.width * (double)stats.height / 1e6;
+    out << std::fixed << std::setprecision(4)
+        << "{\n"
+        << "  \"pipeline\": \"" << pipeline << "\",\n"
+        << "  \"mode\": \"stream\",\n"
+        << "  \"width\": " << stats.width << ",\n"
+        << "  \"height\": " << stats.height << ",\n"
+        << "  \"strip_rows\": " << stats.strip_rows << ",\n"
+        << "  \"halo\": " << stats.halo << ",\n"
+        << "  \"strips\": " << stats.strips << ",\n"
+        << "  \"buffer_bytes\": " << stats.buffer_bytes << ",\n"
+        << "  \"wall_ms\": " << stats.wall_ms << ",\n"
+        << "  \"compute_ms\": " << stats.compute_ms << ",\n"
+        << "  \"read_ms\": " << stats.read_ms << ",\n"
+        << "  \"write_ms\": " << stats.write_ms << ",\n"
+        << "  \"mpix_per_s\": " << megapixels * 1000.0 / stats.wall_ms;
+    write_arena_json(out, stats.arena);
+    out << "\n}\n";
+    return (bool)out;
+}
+
+// Calls process(input, output) once per strip of options.strip_rows output rows, then
+// emit(output) to consume them. input holds the strip plus up to halo rows above and
+// below (fewer at the image edges) and output the strip's rows with
+// options.output_channels channels; both are interleaved and have their y min set to
+// the image row they start at, so the generator sees image coordinates. Rows shared by
+// neighbouring strips' halos are read once and carried over.
+template <typename Process, typename Emit>
+int for_each_strip(PpmReader &reader, const RunnerOptions &options, int halo, StreamStats &stats,
+                   Process &&process, Emit &&emit) {
+    using Halide::Buffer;
+    const int width = reader.width();
+    const int height = reader.height();
+    const int out_channels = options.output_channels;
+    const size_t row_bytes = (size_t)width * 3;
+    const int strip_rows = std::max(1, std::min(options.strip_rows, height));
+
+    Buffer<uint8_t> window = Buffer<uint8_t>::make_interleaved(width, strip_rows + 2 * halo, 3);
+    Buffer<uint8_t> output_rows = Buffer<uint8_t>::make_interleaved(width, strip_rows, out_channels);
+    stats.width = width;
+    stats.height = height;
+    stats.strip_rows = strip_rows;
+    stats.halo = halo;
+    stats.buffer_bytes = (size_t)(strip_rows + 2 * halo) * row_bytes + (size_t)strip_rows * width * out_channels;
+
+    int loaded_min = 0, loaded_end = 0;  // image rows currently in the window
+    for (int y0 = 0; y0 < height; y0 += strip_rows) {
+        const int rows = std::min(strip_rows, height - y0);
+        const int in_min = std::max(0, y0 - halo);
+        const int in_end = std::min(height, y0 + rows + halo);
+
+        auto read_start = BenchClock::now();
+        const int kept = std::max(0, loaded_end - in_min);
+        if (kept > 0 && in_min > loaded_min) {
+            std::memmove(window.data(), window.data() + (in_min - loaded_min) * row_bytes, kept * row_bytes);
+        }
+        if (!reader.read_rows(window.data() + kept * row_bytes, in_end - in_min - kept)) {
+            std::cerr << "Input ended early at row " << in_min + kept << "\n";
+            return 1;
+        }
+        loaded_min = in_min;
+        loaded_end = in_end;
+        stats.read_ms += elapsed_ms(read_start);
+
+        Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(window.data(), width, in_end - in_min, 3);
+        input.set_min(0, in_min);
+        Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(output_rows.data(), width, rows, out_channels);
+        output.set_min(0, y0);
+
+        auto compute_start = BenchClock::now();
+        if (int error = process(input, output)) {
+            std::cerr << "Pipeline failed on rows " << y0 << "-" << y0 + rows - 1 << "\n";
+            return error;
+        }
+        stats.compute_ms += elapsed_ms(compute_start);
+
+        if (int error = emit(output)) {
+            return error;
+        }
+        stats.strips++;
+    }
+    return 0;
+}
+
+// Streams <input>.ppm through process(input, output) into <output>.ppm (.pgm)
+template <typename Process>
+int run_stream(const RunnerOptions &options, const std::string &pipeline, const std::string &in_path,
+               const std::string &out_path, int halo, Process &&process) {
+    if (!is_ppm_path(out_path)) {
+        std::cerr << "Streaming writes binary PPM/PGM; use a .ppm or .pgm output path\n";
+        return 1;
+    }
+    PpmReader reader;
+    if (!reader.open(in_path)) {
+        return 1;
+    }
+    PpmWriter writer;
+    if (!writer.open(out_path, reader.width(), reader.height(), options.output_channels)) {
+        std::cerr << "Failed to open output image: " << out_path << "\n";
+        return 1;
+    }
+
+    StreamStats stats;
+    auto wall_start = BenchClock::now();
+    int result = for_each_strip(reader, options, halo, stats, process, [&](Halide::Buffer<uint8_t> &rows) {
+        auto write_start = BenchClock::now();
+        bool ok = writer.write_rows(rows.data(), rows.height());
+        stats.write_ms += elapsed_ms(write_start);
+        if (!ok) {
+            std::cerr << "Failed to write output image: " << out_path << "\n";
+        }
+        return ok ? 0 : 1;
+    });
+    stats.wall_ms = elapsed_ms(wall_start);
+    stats.arena = HalideArena::instance().stats();
+    if (result != 0) {
+        return result;
+    }
+
+    print_stream_stats(std::cout, stats);
+    if (!options.stats_path.empty() && !write_stream_stats_json(options.stats_path, pipeline, stats)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+// image_compare.h
+// Checks a runner's output against a reference image (--reference): a stored golden,
+// or the float pipeline's output when validating a reduced-precision variant.
+//
+// Include after stb_image.h.
+#pragma once
+
+#include <Halide.h>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "halide_bench.h"
+
+// Identical images report this instead of an infinite PSNR
+constexpr double kIdenticalPsnr = 100.0;
+
+// Fills stats.mismatch (fraction of pixels with any channel different) and stats.psnr.
+// Returns false if the reference cannot be loaded or does not match the output size.
+inline bool compare_with_reference(const Halide::Buffer<uint8_t> &output, const std::string &path, BenchStats &stats) {
+    int width, height, channels;
+    unsigned char *reference = stbi_load(path.c_str(), &width, &height, &channels, output.channels());
+    if (!reference) {
+        std::cerr << "Failed to load reference image: " << path << "\n";
+        return false;
+    }
+    if (width != output.width() || height != output.height()) {
+        std::cerr << "Reference " << path << " is " << width << "x" << height << ", output is "
+                  << output.width() << "x" << output.height() << "\n";
+        stbi_image_free(reference);
+        return false;
+    }
+
+    const int c_count = output.channels();
+    long long differing_pixels = 0;
+    double squared_error = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool differs = false;
+            for (int c = 0; c < c_count; c++) {
+                int diff = (int)output(x, y, c) - reference[((size_t)y * width + x) * c_count + c];
+                squared_error += diff * diff;
+                differs |= diff != 0;
+            }
+            differing_pixels += differs;
+        }
+    }
+    stbi_image_free(reference);
+
+    double mse = squared_error / ((double)width * height * c_count);
+    stats.compared = true;
+    stats.mismatch = (double)differing_pixels / ((double)width * height);
+    stats.psnr = mse > 0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : kIdenticalPsnr;
+    return true;
+}
+
+// Applies --min-psnr when given, otherwise --max-mismatch (default 0: exact match)
+inline bool check_reference(const RunnerOptions &options, const Halide::Buffer<uint8_t> &output, BenchStats &stats) {
+    if (!compare_with_reference(output, options.reference, stats)) {
+        return false;
+    }
+    bool pass = options.min_psnr > 0 ? stats.psnr >= options.min_psnr : stats.mismatch <= options.max_mismatch;
+    std::cout << std::fixed << std::setprecision(4)
+              << "Reference " << options.reference << ": " << stats.mismatch * 100.0 << "% pixels differ, PSNR "
+              << std::setprecision(2) << stats.psnr << " dB" << (pass ? "" : " (FAILED)") << "\n"
+              << std::defaultfloat;
+    return pass;
+}
@@ -0,0 +1,128 @@
+// runner_options.h
+// Command-line options shared by every Halide example runner.
+// Flags are stripped from argv so each runner keeps its own positional arguments.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+struct RunnerOptions {
+    int warmup = 0;          // untimed runs before measuring
+    int iterations = 1;      // timed runs
+    std::string stats_path;  // write timing statistics as JSON here
+    std::string profile_path;  // write the per-stage profile as JSON (halide_profile.h)
+    bool batch = false;      // input is a directory or manifest, output a directory
+    std::string isa;         // cap the multitarget dispatch: sse41, avx2 or avx512
+    std::string reference;   // compare the output against this image
+    double max_mismatch = 0; // allowed fraction of differing pixels
+    double min_psnr = 0;     // if set, compare by PSNR (dB) instead
+    bool stream = false;     // process PPM input strip by strip (halide_stream.h)
+    int strip_rows = 256;    // output rows per strip in streaming mode
+    int serve_width = 0;     // frame size in frame-server mode (halide_serve.h); 0: off
+    int serve_height = 0;
+    int output_channels = 3; // channels the generator writes (set by the runner, not a flag)
+    int size_width = 0;      // mirror-tile the input to this size (scaling sweep); 0: as loaded
+    int size_height = 0;
+    bool arena = true;       // pool Halide's heap allocations (halide_arena.h)
+    size_t arena_limit_mib = 256;  // idle bytes the arena keeps before releasing the oldest sizes
+    bool pack = false;       // batch mode: one call per image size (halide_batch.h)
+    int tile_width = 0;      // with --pack, cut images into tiles of this size; 0: whole
+    int tile_height = 0;
+};
+
+// Progress messages go to stderr when stdout may carry frames (--serve)
+inline std::ostream &runner_log(const RunnerOptions &options) {
+    return options.serve_width > 0 ? std::cerr : std::cout;
+}
+
+inline void print_runner_flags(std::ostream &os) {
+    os << "Options:\n"
+       << "  --warmup N        untimed warm-up runs (default 0)\n"
+       << "  --iterations N    timed runs (default 1)\n"
+       << "  --stats FILE      write timing statistics as JSON\n"
+       << "  --profile FILE    write per-stage times as JSON (<op>_runner.profile only)\n"
+       << "  --batch           treat <input_image> as a directory or manifest of images\n"
+       << "                    and <output_image> as the output directory\n"
+       << "  --isa NAME        highest CPU variant to dispatch to: sse41, avx2, avx512\n"
+       << "  --reference FILE  fail unless the output matches FILE\n"
+       << "  --max-mismatch F  fraction of pixels allowed to differ (default 0)\n"
+       << "  --min-psnr DB     compare by PSNR instead of exact pixel matches\n"
+       << "  --stream          read and write binary PPM one strip of rows at a time\n"
+       << "  --strip-rows N    rows per strip in streaming mode (default 256)\n"
+       << "  --size WxH        mirror-tile the input image to this size before timing\n"
+       << "  --serve WxH       serve raw RGB frames of this size from <input_image> (- for\n"
+       << "                    stdin, unix:PATH for a local socket) to <output_image> (-)\n"
+       << "  --no-arena        let Halide malloc and free its buffers on every call\n"
+       << "  --arena-limit MIB idle memory the arena keeps pooled (default 256)\n"
+       << "  --pack            with --batch, run same-size images in one call of the batched\n"
+       << "                    generator and time it against one call per image\n"
+       << "  --tile WxH        with --pack, cut each image into WxH tiles (e.g. thumbnails)\n";
+}
+
+// Returns false on an unknown or incomplete flag
+inline bool parse_runner_flags(int &argc, char **argv, RunnerOptions &options) {
+    int positional = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--warmup" && has_value) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--iterations" && has_value) {
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--stats" && has_value) {
+            options.stats_path = argv[++i];
+        } else if (arg == "--profile" && has_value) {
+            options.profile_path = argv[++i];
+        } else if (arg == "--isa" && has_value) {
+            options.isa = argv[++i];
+        } else if (arg == "--reference" && has_value) {
+            options.reference = argv[++i];
+        } else if (arg == "--max-mismatch" && has_value) {
+            options.max_mismatch = std::atof(argv[++i]);
+        } else if (arg == "--min-psnr" && has_value) {
+            options.min_psnr = std::atof(argv[++i]);
+        } else if (arg == "--strip-rows" && has_value) {
+            options.strip_rows = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--arena-limit" && has_value) {
+            options.arena_limit_mib = (size_t)std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--serve" && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.serve_width, &options.serve_height) != 2 ||
+                options.serve_width <= 0 || options.serve_height <= 0) {
+                std::cerr << "--serve expects WIDTHxHEIGHT, got " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--size" && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.size_width, &options.size_height) != 2 ||
+                options.size_width <= 0 || options.size_height <= 0) {
+                std::cerr << "--size expects WIDTHxHEIGHT, got " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--tile" && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.tile_width, &options.tile_height) != 2 ||
+                options.tile_width <= 0 || options.tile_height <= 0) {
+                std::cerr << "--tile expects WIDTHxHEIGHT, got " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--pack") {
+            options.pack = true;
+        } else if (arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg == "--no-arena") {
+            options.arena = false;
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown or incomplete option: " << arg << "\n";
+            return false;
+        } else {
+            argv[positional++] = argv[i];
+        }
+    }
+    argc = positional;
+    argv[argc] = nullptr;
+    return true;
+}
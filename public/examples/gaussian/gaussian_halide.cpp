@@ -0,0 +1,255 @@
+// Generator.cpp
+#include <Halide.h>
+#include <string>
+using namespace Halide;
+
+// Large-radius Gaussian blur with the sigma as a run-time input. Three box filters in a
+// row approximate a Gaussian (the widths are chosen so the cascade's variance is sigma^2,
+// after Kovesi), and each box is the difference of two entries of a running sum, so a
+// pass costs the same per pixel at sigma 2 or 50. Three passes run along the rows, then
+// three down the columns.
+class BoxGaussianGenerator : public Halide::Generator<BoxGaussianGenerator> {
+public:
+    // Frame size the autoscheduler tunes for; build-halide.sh builds one per size class
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
+    Input<Buffer<uint8_t>> input{"input", 3};
+    Input<float> sigma{"sigma", 10.0f};  // pixels
+    Output<Buffer<uint8_t>> output{"output", 3};
+
+    void generate() {
+        Var x("x"), y("y"), c("c");
+
+        Func input_bounded("input_bounded");
+        input_bounded = BoundaryConditions::repeat_edge(input);
+
+        // m boxes of odd width wl and 3 - m of width wl + 2
+        Expr ideal = sqrt(4.0f * sigma * sigma + 1.0f);
+        Expr wl = cast<int>(floor(ideal));
+        wl = select(wl % 2 == 0, wl - 1, wl);
+        Expr m = cast<int>(round((12.0f * sigma * sigma - 3 * wl * wl - 12 * wl - 9) / (-4.0f * wl - 4)));
+        Expr radius[3];
+        for (int i = 0; i < 3; i++) {
+            radius[i] = select(i < m, wl / 2, wl / 2 + 1);
+        }
+
+        // One box pass along an axis. The running sum is scanned over (lo, hi] of that
+        // axis from a zero at lo, which makes the pass exact on [lo + radius + 1, hi - radius].
+        // Each pass rounds back to 8 bits.
+        struct BoxPass {
+            Func box, sum;
+            RDom scan;
+        };
+        auto box_pass = [&](Func in, int axis, Expr r, Expr lo, Expr hi, const std::string &name) {
+            Func sum(name + "_sum"), box(name);
+            RDom s(lo + 1, hi - lo, name + "_s");
+            sum(x, y, c) = 0;
+            Expr diff;
+            if (axis == 0) {
+                sum(s, y, c) = sum(s - 1, y, c) + cast<int32_t>(in(s, y, c));
+                diff = sum(x + r, y, c) - sum(x - r - 1, y, c);
+            } else {
+                sum(x, s, c) = sum(x, s - 1, c) + cast<int32_t>(in(x, s, c));
+                diff = sum(x, y + r, c) - sum(x, y - r - 1, c);
+            }
+            Expr width = 2 * r + 1;
+            box(x, y, c) = cast<uint8_t>((diff + width / 2) / width);
+            return BoxPass{box, sum, s};
+        };
+
+        // Scan ranges from the last pass back to the first: each pass must be exact over
+        // the range the next one scans, and the last over the whole image
+        BoxPass passes[2][3];
+        for (int axis = 0; axis < 2; axis++) {
+            Expr lo[3], hi[3];
+            Expr next_lo = input.dim(axis).min(), next_hi = input.dim(axis).max();
+            for (int i = 2; i >= 0; i--) {
+                lo[i] = next_lo - radius[i] - 1;
+                hi[i] = next_hi + radius[i];
+                next_lo = lo[i] + 1;
+                next_hi = hi[i];
+            }
+            const char *axis_name = axis == 0 ? "x" : "y";
+            for (int i = 0; i < 3; i++) {
+                Func in = i > 0 ? passes[axis][i - 1].box : axis == 0 ? input_bounded : passes[0][2].box;
+                passes[axis][i] = box_pass(in, axis, radius[i], lo[i], hi[i], "box_" + std::string(axis_name) + std::to_string(i));
+            }
+        }
+
+        output(x, y, c) = passes[1][2].box(x, y, c);
+
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(3);
+        output.dim(2).set_stride(1).set_bounds(0, 3);
+
+        // Set estimates for autoscheduler
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        sigma.set_estimate(10.0f);
+
+        if (!using_autoscheduler()) {
+            // Hand-written schedule (the "manual" variant). The row passes run in parallel
+            // over rows, all three on one row before the next; each scan walks the row with
+            // the channels unrolled. The column passes run in parallel over 64-wide column
+            // strips, each scan stepping down the strip one vector of columns at a time.
+            Var yo("yo"), yi("yi"), xo("xo"), xi("xi");
+            const int vec = natural_vector_size<int32_t>();
+            Func rows = passes[0][2].box;
+            rows.compute_root().reorder(x, c, y)
+                .split(y, yo, yi, 8, TailStrategy::GuardWithIf).parallel(yo).vectorize(x, vec);
+            for (int i = 0; i < 3; i++) {
+                BoxPass &pass = passes[0][i];
+                if (i < 2) {
+                    pass.box.compute_at(rows, yi).vectorize(x, vec);
+                }
+                pass.sum.compute_at(rows, yi);
+                pass.sum.update().reorder(c, pass.scan.x).unroll(c);
+            }
+
+            output.bound(c, 0, 3).split(x, xo, xi, 64, TailStrategy::GuardWithIf)
+                  .reorder(c, xi, y, xo).unroll(c).parallel(xo).vectorize(xi, vec);
+            for (int i = 0; i < 3; i++) {
+                BoxPass &pass = passes[1][i];
+                if (i < 2) {
+                    pass.box.compute_at(output, xo).vectorize(x, vec);
+                }
+                pass.sum.compute_at(output, xo).vectorize(x, vec);
+                pass.sum.update().reorder(c, x, pass.scan.x).vectorize(x, vec);
+            }
+        }
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(BoxGaussianGenerator, box_gaussian)
+
+// Runner.cpp
+#include <Halide.h>
+#include <cmath>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../../../runtime/stb_image_write.h"
+
+#include "box_gaussian_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc < 3 || argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [sigma] [options]\n";
+        std::cerr << "Default: sigma=10 (pixels)\n";
+        print_runner_flags(std::cerr);
+        return 1;
+    }
+
+    // Sigma is a pipeline input, so any value runs without regenerating
+    float sigma = argc >= 4 ? std::stof(argv[3]) : 10.0f;
+    if (sigma < 0.5f) {
+        std::cerr << "Sigma must be at least 0.5\n";
+        return 1;
+    }
+
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
+        return 1;
+    }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
+
+    if (options.batch) {
+        return run_batch(options, "box_gaussian", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return box_gaussian(input.raw_buffer(), sigma, output.raw_buffer());
+        });
+    }
+
+    if (options.stream) {
+        // The three box radii add up to at most 3 * sigma + 2.25
+        const int halo = (int)std::ceil(3 * sigma) + 3;
+        return run_stream(options, "box_gaussian", argv[1], argv[2], halo, [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return box_gaussian(input.raw_buffer(), sigma, output.raw_buffer());
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "box_gaussian", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return box_gaussian(input.raw_buffer(), sigma, output.raw_buffer());
+        });
+    }
+
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
+        std::cerr << "Failed to load input image: " << argv[1] << "\n";
+        return 1;
+    }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
+
+    std::cout << "Loaded image: " << width << "x" << height
+              << " (" << channels << " channels)\n";
+
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
+
+    // Interleaved output doubles as the encoder input
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, 3);
+
+    std::cout << "Processing image with a box-cascade Gaussian (sigma=" << sigma << ")...\n";
+
+    int result = run_benchmark(options, stats, [&] {
+        return box_gaussian(input.raw_buffer(), sigma, output.raw_buffer());
+    });
+    if (result != 0) {
+        std::cerr << "Error in Gaussian blur\n";
+        return 1;
+    }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "box_gaussian")) {
+        return 1;
+    }
+
+    // Optional check against a reference image (a golden or another schedule's output)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
+
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
+
+    if (!success) {
+        std::cerr << "Failed to save output image\n";
+        return 1;
+    }
+
+    std::cout << "Saved output: " << argv[2] << "\n";
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "box_gaussian", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
+}
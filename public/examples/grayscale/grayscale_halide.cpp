@@ -6,76 +6,120 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
 #define STB_IMAGE_WRITE_IMPLEMENTATION  
 #include "../../../runtime/stb_image_write.h"
 
 #include "grayscale_auto_aot.h"
+#include "grayscale_batch_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
 
 using namespace Halide;
 
+// build-halide.sh defines HL_PARAM_<name> for each generator param of a variant build
+#ifndef HL_PARAM_output_channels
+#define HL_PARAM_output_channels 3
+#endif
+
 int main(int argc, char **argv) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image>\n";
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [options]\n";
+        print_runner_flags(std::cerr);
+        return 1;
+    }
+    options.output_channels = HL_PARAM_output_channels;
+
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
         return 1;
     }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
+
+    if (options.batch && options.pack) {
+        // Same-size images (or --tile thumbnails) in one call of the 4-D generator
+        return run_packed_batch(options, "grayscale_batch", argv[1], argv[2], [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return grayscale_auto(input.raw_buffer(), output.raw_buffer());
+        }, [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return grayscale_batch(input.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.batch) {
+        return run_batch(options, "grayscale_auto", argv[1], argv[2], [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return grayscale_auto(input.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.stream) {
+        // Pointwise: no halo rows needed
+        return run_stream(options, "grayscale_auto", argv[1], argv[2], 0, [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return grayscale_auto(input.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "grayscale_auto", argv[1], argv[2], [](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return grayscale_auto(input.raw_buffer(), output.raw_buffer());
+        });
+    }
 
-    // Load input image using STB
-    int width, height, channels;
-    unsigned char *input_data = stbi_load(argv[1], &width, &height, &channels, 3);
-    if (!input_data) {
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
         std::cerr << "Failed to load input image: " << argv[1] << "\n";
         return 1;
     }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
 
     std::cout << "Loaded image: " << width << "x" << height 
               << " (" << channels << " channels)\n";
 
-    // Create Halide buffer from loaded data
-    Buffer<uint8_t> input(width, height, 3);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                input(x, y, c) = input_data[(y * width + x) * 3 + c];
-            }
-        }
-    }
-    stbi_image_free(input_data);
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
 
-    // Prepare output buffer
-    Buffer<uint8_t> output(width, height, 3);
+    // Interleaved output doubles as the encoder input (RGB, or gray for single-channel builds)
+    const int out_channels = options.output_channels;
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, out_channels);
 
-    // Single execution
+    // Warm-up and timed runs
     std::cout << "Processing image with auto-scheduled grayscale...\n";
-    
-    int result = grayscale_auto(input.raw_buffer(), output.raw_buffer());
-    
+
+    int result = run_benchmark(options, stats, [&] {
+        return grayscale_auto(input.raw_buffer(), output.raw_buffer());
+    });
     if (result != 0) {
         std::cerr << "Error in grayscale conversion\n";
         return 1;
     }
-
-    // Convert output to contiguous array for STB
-    unsigned char *output_data = new unsigned char[width * height * 3];
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < 3; c++) {
-                output_data[(y * width + x) * 3 + c] = output(x, y, c);
-            }
-        }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "grayscale_auto")) {
+        return 1;
     }
 
-    // Save output using STB
-    const char *ext = strrchr(argv[2], '.');
-    bool success = false;
-    if (ext && strcmp(ext, ".png") == 0) {
-        success = stbi_write_png(argv[2], width, height, 3, output_data, width * 3);
-    } else if (ext && strcmp(ext, ".jpg") == 0) {
-        success = stbi_write_jpg(argv[2], width, height, 3, output_data, 95);
-    } else {
-        std::cerr << "Unsupported output format. Use .png or .jpg\n";
-    }
-    
-    delete[] output_data;
+    // Optional check against a reference image (a golden or a higher-precision variant)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
+
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
     
     if (!success) {
         std::cerr << "Failed to save output image\n";
@@ -83,45 +127,112 @@ int main(int argc, char **argv) {
     }
     
     std::cout << "Saved output: " << argv[2] << "\n";
-    return 0;
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "grayscale_auto", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
 }
 // Generator.cpp
 #include "Halide.h"
 
 using namespace Halide;
 
+// Luma with the weights scaled by 1024 (0.299 -> 306, 0.587 -> 601, 0.114 -> 117), in
+// integer arithmetic for better performance
+static Expr gray_level(Expr r, Expr g, Expr b) {
+    Expr gray_value = (306 * cast<int32_t>(r) +
+                       601 * cast<int32_t>(g) +
+                       117 * cast<int32_t>(b)) >> 10;
+    return cast<uint8_t>(clamp(gray_value, 0, 255));
+}
+
 class GrayscaleAutoGenerator : public Halide::Generator<GrayscaleAutoGenerator> {
 public:
+    // 3 replicates gray to RGB for a fair comparison with the DSL; 1 writes 8-bit gray only
+    GeneratorParam<int> output_channels{"output_channels", 3, 1, 3};
+    // Frame size the autoscheduler tunes for; build-halide.sh builds one per size class
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
     Input<Buffer<uint8_t>> input{"input", 3};
-    Output<Buffer<uint8_t>> output{"output", 3};  // Keep 3 channels for fair comparison
+    Output<Buffer<uint8_t>> output{"output", 3};
 
     void generate() {
         Var x("x"), y("y"), c("c");
 
         // Grayscale conversion using standard weights
-        Expr r = input(x, y, 0);
-        Expr g = input(x, y, 1);
-        Expr b = input(x, y, 2);
-        
-        // Use integer arithmetic for better performance
-        // Weights scaled by 1024: 0.299*1024=306, 0.587*1024=601, 0.114*1024=117
-        Expr gray_value = (306 * cast<int32_t>(r) + 
-                          601 * cast<int32_t>(g) + 
-                          117 * cast<int32_t>(b)) >> 10;
-        
-        // Clamp to valid range and cast
-        gray_value = clamp(gray_value, 0, 255);
-        Expr gray_uint8 = cast<uint8_t>(gray_value);
+        Func gray("gray");
+        gray(x, y) = gray_level(input(x, y, 0), input(x, y, 1), input(x, y, 2));
         
         // Replicate to all channels
-        output(x, y, c) = gray_uint8;
+        output(x, y, c) = gray(x, y);
         
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(output_channels);
+        output.dim(2).set_stride(1).set_bounds(0, output_channels);
+
         // Set estimates for autoscheduler
-        input.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
-        output.set_estimates({{0, 1920}, {0, 1080}, {0, 3}});
-        
-        // No manual scheduling - let the autoscheduler handle everything
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, output_channels}});
+
+        if (!using_autoscheduler()) {
+            // Hand-written schedule (the "manual" variant): parallel strips of rows,
+            // one vector of gray values per step, stored with the channels unrolled
+            Var yo("yo"), yi("yi");
+            const int vec = natural_vector_size<uint8_t>();
+            output.reorder(c, x, y).bound(c, 0, output_channels).unroll(c)
+                  .split(y, yo, yi, 32, TailStrategy::GuardWithIf).parallel(yo);
+            // Vector-multiple widths need no overlapping last vector
+            output.specialize(output.dim(0).extent() % vec == 0).vectorize(x, vec, TailStrategy::RoundUp);
+            output.vectorize(x, vec);
+            gray.compute_at(output, x).vectorize(x);
+        }
+    }
+};
+
+// The same conversion over a batch of equally sized images (x, y, c, n) in one call, for
+// thumbnail workloads where a call per image is dominated by call and fork/join
+// overhead. Runners pack the images with --batch --pack.
+class GrayscaleBatchGenerator : public Halide::Generator<GrayscaleBatchGenerator> {
+public:
+    GeneratorParam<int> output_channels{"output_channels", 3, 1, 3};
+    GeneratorParam<int> estimate_width{"estimate_width", 256};
+    GeneratorParam<int> estimate_height{"estimate_height", 256};
+    GeneratorParam<int> estimate_batch{"estimate_batch", 64};
+
+    Input<Buffer<uint8_t>> input{"input", 4};
+    Output<Buffer<uint8_t>> output{"output", 4};
+
+    void generate() {
+        Var x("x"), y("y"), c("c"), n("n");
+
+        Func gray("gray");
+        gray(x, y, n) = gray_level(input(x, y, 0, n), input(x, y, 1, n), input(x, y, 2, n));
+        output(x, y, c, n) = gray(x, y, n);
+
+        // Each image interleaved as in the single-image generator, images one after another
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(output_channels);
+        output.dim(2).set_stride(1).set_bounds(0, output_channels);
+
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}, {0, estimate_batch}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, output_channels}, {0, estimate_batch}});
+
+        if (!using_autoscheduler()) {
+            // One image per parallel task; small images are cheaper whole than in strips
+            const int vec = natural_vector_size<uint8_t>();
+            output.reorder(c, x, y, n).bound(c, 0, output_channels).unroll(c).parallel(n);
+            output.specialize(output.dim(0).extent() % vec == 0).vectorize(x, vec, TailStrategy::RoundUp);
+            output.vectorize(x, vec);
+            gray.compute_at(output, x).vectorize(x);
+        }
     }
 };
 
-HALIDE_REGISTER_GENERATOR(GrayscaleAutoGenerator, grayscale_auto)
\ No newline at end of file
+HALIDE_REGISTER_GENERATOR(GrayscaleAutoGenerator, grayscale_auto)
+HALIDE_REGISTER_GENERATOR(GrayscaleBatchGenerator, grayscale_batch)
\ No newline at end of file
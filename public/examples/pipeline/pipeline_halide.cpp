@@ -0,0 +1,346 @@
+// Generator.cpp
+#include <Halide.h>
+#include <string>
+#include <vector>
+using namespace Halide;
+
+// One fused pipeline built from an ordered list of the example operators: the Halide side
+// of a DSL pipe chain such as canny.dsl's
+// `pixel_op(grayscale) | stencil_op(5, gaussian_blur(5)) | stencil_op(3, sobel_xy) | ...`,
+// without a PNG round trip between processes. Every stage works on float planes in [0, 1]:
+//   grayscale   3 channels -> 1 (0.299 R + 0.587 G + 0.114 B)
+//   brightness  adds the brightness input, clamped to [0, 1]
+//   gaussian    5x5 Gaussian (/159) per channel
+//   sobel       1 channel -> 2 (gx, gy)
+//   nms         gx, gy -> gradient magnitude, kept only at local maxima across the edge
+//   threshold   1 channel -> 1 strong, 0.5 weak, 0 none
+class PipelineGenerator : public Halide::Generator<PipelineGenerator> {
+public:
+    // Operators in order, separated by ',' or '|'
+    GeneratorParam<std::string> stages{"stages", "grayscale,gaussian,sobel,nms,threshold"};
+    // Compute every stage over the whole frame before the next one starts, as a chain of
+    // separate pipelines would; by default all stages run per strip of rows. Manual schedule only.
+    GeneratorParam<bool> staged{"staged", false};
+    // Frame size the autoscheduler tunes for (one build per size class)
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
+    Input<Buffer<uint8_t>> input{"input", 3};
+    Input<float> brightness{"brightness", 0.2f};
+    Input<float> low_threshold{"low_threshold", 0.1f};
+    Input<float> high_threshold{"high_threshold", 0.3f};
+    Output<Buffer<uint8_t>> output{"output", 3};
+
+    void generate() {
+        user_assert(!(staged && using_autoscheduler())) << "staged=true needs the manual schedule\n";
+
+        Func input_float("input_float");
+        input_float(x, y, c) = cast<float>(input(x, y, c)) / 255.0f;
+
+        Plane plane{input_float, 3};
+        for (const std::string &op : split_stages(stages.value())) {
+            plane = apply(op, plane);
+            funcs.push_back(plane.f);
+        }
+        user_assert(plane.channels != 2) << "sobel must be followed by nms\n";
+
+        // Single-channel results are written as gray
+        Expr value = plane.channels == 1 ? plane.f(x, y, 0) : plane.f(x, y, c);
+        output(x, y, c) = cast<uint8_t>(clamp(value, 0.0f, 1.0f) * 255.0f);
+
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(3);
+        output.dim(2).set_stride(1).set_bounds(0, 3);
+
+        // Set estimates for autoscheduler
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        brightness.set_estimate(0.2f);
+        low_threshold.set_estimate(0.1f);
+        high_threshold.set_estimate(0.3f);
+
+        if (!using_autoscheduler()) {
+            const int vec = natural_vector_size<float>();
+            output.reorder(c, x, y).bound(c, 0, 3).unroll(c);
+            Expr whole_vectors = output.dim(0).extent() % vec == 0;
+            if (staged) {
+                // One parallel full-frame pass per stage, intermediates round-trip through memory
+                output.parallel(y);
+                output.specialize(whole_vectors).vectorize(x, vec, TailStrategy::RoundUp);
+                output.vectorize(x, vec);
+                for (Func f : funcs) {
+                    f.compute_root().parallel(y).vectorize(x, vec);
+                }
+            } else {
+                // Parallel strips of rows with every stage sliding down the strip one row at a
+                // time, so intermediates stay a few rows tall and in cache
+                Var yo("yo"), yi("yi");
+                output.split(y, yo, yi, 32, TailStrategy::GuardWithIf).parallel(yo);
+                // Rows of whole vectors skip the shifted last vector
+                output.specialize(whole_vectors).vectorize(x, vec, TailStrategy::RoundUp);
+                output.vectorize(x, vec);
+                for (Func f : funcs) {
+                    f.store_at(output, yo).compute_at(output, yi).vectorize(x, vec);
+                }
+            }
+        }
+    }
+
+private:
+    // f(x, y, c) for c in [0, channels); single-channel planes ignore c
+    struct Plane {
+        Func f;
+        int channels;
+    };
+
+    Var x{"x"}, y{"y"}, c{"c"};
+    std::vector<Func> funcs;  // intermediates the manual schedule places, in order
+
+    static std::vector<std::string> split_stages(const std::string &list) {
+        std::vector<std::string> ops;
+        std::string op;
+        for (char ch : list + ",") {
+            if (ch == ',' || ch == '|') {
+                if (!op.empty()) {
+                    ops.push_back(op);
+                }
+                op.clear();
+            } else if (ch != ' ') {
+                op += ch;
+            }
+        }
+        user_assert(!ops.empty()) << "stages is empty\n";
+        return ops;
+    }
+
+    // Borders follow the input buffer's own min and extent, so a streaming runner can pass a
+    // strip of rows (min set to its first image row) plus halo rows and get exactly the rows
+    // the full frame would produce
+    Region image_bounds() {
+        return {{input.dim(0).min(), input.dim(0).extent()}, {input.dim(1).min(), input.dim(1).extent()}};
+    }
+
+    Plane apply(const std::string &op, const Plane &in) {
+        Func f(op + "_" + std::to_string(funcs.size()));
+        Func clamped = BoundaryConditions::repeat_edge(in.f, image_bounds());
+
+        if (op == "grayscale") {
+            user_assert(in.channels == 3) << "grayscale needs 3 channels\n";
+            f(x, y, c) = 0.299f * in.f(x, y, 0) + 0.587f * in.f(x, y, 1) + 0.114f * in.f(x, y, 2);
+            return {f, 1};
+        }
+        if (op == "brightness") {
+            f(x, y, c) = clamp(in.f(x, y, c) + brightness, 0.0f, 1.0f);
+            return {f, in.channels};
+        }
+        if (op == "gaussian") {
+            const float kernel[5][5] = {
+                {2, 4, 5, 4, 2},
+                {4, 9, 12, 9, 4},
+                {5, 12, 15, 12, 5},
+                {4, 9, 12, 9, 4},
+                {2, 4, 5, 4, 2}
+            };
+            Expr sum = 0.0f;
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    sum += clamped(x + dx, y + dy, c) * kernel[dy + 2][dx + 2];
+                }
+            }
+            f(x, y, c) = sum / 159.0f;
+            return {f, in.channels};
+        }
+        if (op == "sobel") {
+            user_assert(in.channels == 1) << "sobel needs 1 channel\n";
+            auto p = [&](int dx, int dy) { return clamped(x + dx, y + dy, 0); };
+            Expr gx = -p(-1, -1) + p(1, -1) - 2.0f * p(-1, 0) + 2.0f * p(1, 0) - p(-1, 1) + p(1, 1);
+            Expr gy = -p(-1, -1) - 2.0f * p(0, -1) - p(1, -1) + p(-1, 1) + 2.0f * p(0, 1) + p(1, 1);
+            f(x, y, c) = select(c == 0, gx, gy);
+            return {f, 2};
+        }
+        if (op == "nms") {
+            user_assert(in.channels == 2) << "nms needs the gx, gy output of sobel\n";
+            Expr gx = in.f(x, y, 0), gy = in.f(x, y, 1);
+            Func magnitude(op + "_magnitude_" + std::to_string(funcs.size()));
+            magnitude(x, y, c) = sqrt(gx * gx + gy * gy);
+            funcs.push_back(magnitude);
+            Func m = BoundaryConditions::repeat_edge(magnitude, image_bounds());
+
+            // Direction sector from |gy| against tan(22.5) and tan(67.5) times |gx|
+            Expr ax = abs(gx), ay = abs(gy);
+            Expr horizontal = ay <= ax * 0.41421356f;
+            Expr vertical = ay >= ax * 2.41421356f;
+            Expr rising = (gx > 0) == (gy > 0);
+            Expr mag1 = select(horizontal, m(x-1, y, 0),
+                        select(vertical, m(x, y-1, 0),
+                        select(rising, m(x+1, y-1, 0),
+                                       m(x-1, y-1, 0))));
+            Expr mag2 = select(horizontal, m(x+1, y, 0),
+                        select(vertical, m(x, y+1, 0),
+                        select(rising, m(x-1, y+1, 0),
+                                       m(x+1, y+1, 0))));
+            Expr mag_curr = magnitude(x, y, 0);
+            f(x, y, c) = select(mag_curr >= mag1 && mag_curr >= mag2, mag_curr, 0.0f);
+            return {f, 1};
+        }
+        if (op == "threshold") {
+            user_assert(in.channels == 1) << "threshold needs 1 channel\n";
+            Expr v = in.f(x, y, 0);
+            f(x, y, c) = select(v >= high_threshold, 1.0f, select(v >= low_threshold, 0.5f, 0.0f));
+            return {f, 1};
+        }
+        user_error << "Unknown stage \"" << op << "\"; expected grayscale, brightness, gaussian, sobel, nms or threshold\n";
+        return in;
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(PipelineGenerator, pipeline_fused)
+
+// Runner.cpp
+#include <Halide.h>
+#include <iostream>
+#include <cstring>
+#include <string>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../../../runtime/stb_image_write.h"
+
+#include "pipeline_fused_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
+
+using namespace Halide;
+
+// build-halide.sh defines HL_PARAM_<name> for each generator param of a variant build
+#ifndef HL_PARAM_stages
+#define HL_PARAM_stages grayscale,gaussian,sobel,nms,threshold
+#endif
+#define PIPELINE_STRINGIFY_(...) #__VA_ARGS__
+#define PIPELINE_STRINGIFY(...) PIPELINE_STRINGIFY_(__VA_ARGS__)
+
+// Rows of context the chain needs above and below an output row: the radii of its stages
+// summed (gaussian 2, sobel 1, nms 1), so strips with that many halo rows match the full frame
+static int chain_halo(const std::string &stages) {
+    int halo = 0;
+    std::string op;
+    for (char ch : stages + ",") {
+        if (ch == ',' || ch == '|') {
+            halo += op == "gaussian" ? 2 : (op == "sobel" || op == "nms") ? 1 : 0;
+            op.clear();
+        } else if (ch != ' ') {
+            op += ch;
+        }
+    }
+    return halo;
+}
+
+int main(int argc, char **argv) {
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc < 3 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [low_threshold] [high_threshold] [brightness] [options]\n";
+        std::cerr << "Defaults: low=0.1, high=0.3, brightness=0.2 (each used only if its stage is in the chain)\n";
+        print_runner_flags(std::cerr);
+        return 1;
+    }
+
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
+        return 1;
+    }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
+
+    float low_threshold = argc >= 4 ? std::stof(argv[3]) : 0.1f;
+    float high_threshold = argc >= 5 ? std::stof(argv[4]) : 0.3f;
+    float brightness = argc >= 6 ? std::stof(argv[5]) : 0.2f;
+
+    if (options.batch) {
+        return run_batch(options, "pipeline_fused", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return pipeline_fused(input.raw_buffer(), brightness, low_threshold, high_threshold, output.raw_buffer());
+        });
+    }
+
+    if (options.stream) {
+        return run_stream(options, "pipeline_fused", argv[1], argv[2], chain_halo(PIPELINE_STRINGIFY(HL_PARAM_stages)),
+                          [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return pipeline_fused(input.raw_buffer(), brightness, low_threshold, high_threshold, output.raw_buffer());
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "pipeline_fused", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return pipeline_fused(input.raw_buffer(), brightness, low_threshold, high_threshold, output.raw_buffer());
+        });
+    }
+
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
+        std::cerr << "Failed to load input image: " << argv[1] << "\n";
+        return 1;
+    }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
+
+    std::cout << "Loaded image: " << width << "x" << height
+              << " (" << channels << " channels)\n";
+
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
+
+    // Interleaved output doubles as the encoder input
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, 3);
+
+    std::cout << "Processing image with the operator chain...\n";
+
+    int result = run_benchmark(options, stats, [&] {
+        return pipeline_fused(input.raw_buffer(), brightness, low_threshold, high_threshold, output.raw_buffer());
+    });
+    if (result != 0) {
+        std::cerr << "Error in operator chain\n";
+        return 1;
+    }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "pipeline_fused")) {
+        return 1;
+    }
+
+    // Optional check against a reference image (e.g. the fused output for the staged build)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
+
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
+
+    if (!success) {
+        std::cerr << "Failed to save output image\n";
+        return 1;
+    }
+
+    std::cout << "Saved output: " << argv[2] << "\n";
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "pipeline_fused", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
+}
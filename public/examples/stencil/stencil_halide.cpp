@@ -0,0 +1,361 @@
+// Generator.cpp
+#include <Halide.h>
+#include <initializer_list>
+using namespace Halide;
+
+// The Halide baseline for the DSL's stencil_op(k, ...): a (2R+1)x(2R+1) weighted sum per
+// channel with the radius taken from the weights buffer at run time (R = 1..7). Radii 1-3
+// (3x3, 5x5, 7x7) get specialized code paths with the taps fully unrolled.
+class StencilGenerator : public Halide::Generator<StencilGenerator> {
+public:
+    // Separable: weights is (2R+1) x 2 holding the horizontal taps in row 0 and the vertical
+    // taps in row 1. Otherwise weights is the full (2R+1) x (2R+1) kernel.
+    GeneratorParam<bool> separable{"separable", true};
+    // Frame size the autoscheduler tunes for; build-halide.sh builds one per size class
+    GeneratorParam<int> estimate_width{"estimate_width", 1920};
+    GeneratorParam<int> estimate_height{"estimate_height", 1080};
+
+    Input<Buffer<uint8_t>> input{"input", 3};
+    Input<Buffer<float>> weights{"weights", 2};
+    Output<Buffer<uint8_t>> output{"output", 3};
+
+    void generate() {
+        Var x("x"), y("y"), c("c");
+
+        Func input_bounded("input_bounded");
+        input_bounded = BoundaryConditions::repeat_edge(input);
+
+        Func input_float("input_float");
+        input_float(x, y, c) = cast<float>(input_bounded(x, y, c)) / 255.0f;
+
+        Expr size = weights.dim(0).extent();
+        Expr radius = size / 2;
+
+        // Weighted sums as update definitions over an RDom, so the taps can be unrolled per
+        // specialization; the RDom extent is the runtime kernel size
+        Func conv_x("conv_x"), conv("conv");
+        RDom r(0, size, "r");
+        RDom rk(0, size, 0, size, "rk");
+        if (separable) {
+            conv_x(x, y, c) = 0.0f;
+            conv_x(x, y, c) += weights(r, 0) * input_float(x + r - radius, y, c);
+            conv(x, y, c) = 0.0f;
+            conv(x, y, c) += weights(r, 1) * conv_x(x, y + r - radius, c);
+        } else {
+            conv(x, y, c) = 0.0f;
+            conv(x, y, c) += weights(rk.x, rk.y) * input_float(x + rk.x - radius, y + rk.y - radius, c);
+        }
+
+        // Convert back to uint8
+        output(x, y, c) = cast<uint8_t>(clamp(conv(x, y, c) * 255.0f, 0.0f, 255.0f));
+
+        // Interleaved (RGBRGB...) layout so runners can pass STB memory without copying
+        input.dim(0).set_stride(3);
+        input.dim(2).set_stride(1).set_bounds(0, 3);
+        output.dim(0).set_stride(3);
+        output.dim(2).set_stride(1).set_bounds(0, 3);
+        weights.dim(0).set_min(0);
+        weights.dim(1).set_min(0);
+
+        // Set estimates for autoscheduler
+        input.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        output.set_estimates({{0, estimate_width}, {0, estimate_height}, {0, 3}});
+        weights.set_estimates({{0, 3}, {0, separable ? 2 : 3}});
+
+        if (!using_autoscheduler()) {
+            // Hand-written schedule (the "manual" variant): parallel strips of rows, channels
+            // unrolled innermost so loads and stores stay interleaved. Radii 1-3 unroll the taps
+            // inside the vectorized x, so each output vector is summed in registers; the generic
+            // size loops the taps outside x instead, one vector multiply-add across the row per
+            // tap. Specializations are declared first: each keeps the schedule it was given.
+            Var yo("yo"), yi("yi");
+            const int vec = natural_vector_size<float>();
+            output.reorder(c, x, y).bound(c, 0, 3).unroll(c)
+                  .split(y, yo, yi, 32, TailStrategy::GuardWithIf).parallel(yo);
+            // Whole-vector widths: no shifted last vector per row
+            output.specialize(output.dim(0).extent() % vec == 0).vectorize(x, vec, TailStrategy::RoundUp);
+            output.vectorize(x, vec);
+
+            conv.compute_at(output, yi).reorder(c, x, y).unroll(c).vectorize(x, vec);
+            if (separable) {
+                conv_x.store_at(output, yo).compute_at(output, yi)
+                      .reorder(c, x, y).unroll(c).vectorize(x, vec);
+                for (int k : {1, 2, 3}) {
+                    conv_x.update().specialize(size == 2 * k + 1)
+                          .reorder(c, r, x, y).unroll(c).unroll(r).vectorize(x, vec);
+                    conv.update().specialize(size == 2 * k + 1)
+                        .reorder(c, r, x, y).unroll(c).unroll(r).vectorize(x, vec);
+                }
+                conv_x.update().reorder(c, x, r, y).unroll(c).vectorize(x, vec);
+                conv.update().reorder(c, x, r, y).unroll(c).vectorize(x, vec);
+            } else {
+                for (int k : {1, 2, 3}) {
+                    conv.update().specialize(size == 2 * k + 1)
+                        .reorder(c, rk.x, rk.y, x, y).unroll(c).unroll(rk.x).unroll(rk.y).vectorize(x, vec);
+                }
+                conv.update().reorder(c, x, rk.x, rk.y, y).unroll(c).vectorize(x, vec);
+            }
+        }
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(StencilGenerator, stencil_op)
+
+// Runner.cpp
+#include <Halide.h>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../../runtime/stb_image.h"
+#include "halide_deflate.h"  // before stb_image_write.h: multi-threaded PNG deflate
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../../../runtime/stb_image_write.h"
+
+#include "stencil_op_aot.h"
+#include "halide_batch.h"
+#include "halide_bench.h"
+#include "halide_dispatch.h"
+#include "halide_image_io.h"
+#include "halide_profile.h"
+#include "halide_serve.h"
+#include "halide_stream.h"
+#include "image_compare.h"
+
+using namespace Halide;
+
+// build-halide.sh defines HL_PARAM_<name> for each generator param of a variant build
+#ifndef HL_PARAM_separable
+#define HL_PARAM_separable true
+#endif
+
+constexpr int kMaxRadius = 7;
+
+// Comma-separated weights appended to <weights>; false on an empty or malformed entry
+static bool parse_weight_list(const std::string &list, std::vector<float> &weights) {
+    size_t start = 0;
+    while (true) {
+        size_t comma = list.find(',', start);
+        std::string item = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        char *end = nullptr;
+        float weight = std::strtof(item.c_str(), &end);
+        if (item.empty() || *end != '\0') {
+            return false;
+        }
+        weights.push_back(weight);
+        if (comma == std::string::npos) {
+            return true;
+        }
+        start = comma + 1;
+    }
+}
+
+// Scales the weights to sum to 1; false if they sum to 0
+static bool normalize_weights(std::vector<float> &weights) {
+    float total = 0;
+    for (float w : weights) {
+        total += w;
+    }
+    if (total == 0) {
+        return false;
+    }
+    for (float &w : weights) {
+        w /= total;
+    }
+    return true;
+}
+
+// 1-D taps from "gaussian:R" (binomial, [1 2 1] for R = 1), "box:R" or a comma-separated
+// list of an odd number of weights; normalized to sum to 1. Empty on a malformed spec.
+static std::vector<float> parse_kernel(const std::string &spec) {
+    std::vector<float> taps;
+    size_t colon = spec.find(':');
+    if (colon != std::string::npos) {
+        std::string kind = spec.substr(0, colon);
+        int radius = std::atoi(spec.c_str() + colon + 1);
+        if (radius < 1 || radius > kMaxRadius) {
+            return {};
+        }
+        if (kind == "gaussian") {
+            taps.push_back(1.0f);
+            for (int k = 1; k <= 2 * radius; k++) {
+                taps.push_back(taps.back() * (2 * radius - k + 1) / k);
+            }
+        } else if (kind == "box") {
+            taps.assign(2 * radius + 1, 1.0f);
+        } else {
+            return {};
+        }
+    } else if (!parse_weight_list(spec, taps) || taps.size() % 2 == 0 || taps.size() > 2 * kMaxRadius + 1) {
+        return {};
+    }
+    return normalize_weights(taps) ? taps : std::vector<float>{};
+}
+
+// A full KxK kernel as rows separated by '/', top to bottom ("1,2,1/2,8,2/1,2,1"), for
+// kernels that are not an outer product; row-major, normalized to sum to 1, size set to K.
+// Empty on a malformed spec.
+static std::vector<float> parse_full_kernel(const std::string &spec, int &size) {
+    std::vector<float> weights;
+    size = 0;
+    size_t start = 0;
+    while (true) {
+        size_t slash = spec.find('/', start);
+        size_t before = weights.size();
+        if (!parse_weight_list(spec.substr(start, slash == std::string::npos ? std::string::npos : slash - start), weights)) {
+            return {};
+        }
+        if (size == 0) {
+            size = (int)(weights.size() - before);
+        } else if ((int)(weights.size() - before) != size) {
+            return {};
+        }
+        if (slash == std::string::npos) {
+            break;
+        }
+        start = slash + 1;
+    }
+    if (size % 2 == 0 || size > 2 * kMaxRadius + 1 || (int)weights.size() != size * size) {
+        return {};
+    }
+    return normalize_weights(weights) ? weights : std::vector<float>{};
+}
+
+// The weights buffer for a kernel spec: separable builds take the taps per axis, non-separable
+// ones a full KxK kernel or the outer product of the 1-D taps. Undefined on a malformed spec.
+static Buffer<float> make_weights(const std::string &spec) {
+    if (spec.find('/') != std::string::npos) {
+        int size = 0;
+        std::vector<float> full = parse_full_kernel(spec, size);
+        if (full.empty() || HL_PARAM_separable) {
+            return Buffer<float>();
+        }
+        Buffer<float> weights(size, size);
+        weights.for_each_element([&](int i, int j) { weights(i, j) = full[j * size + i]; });
+        return weights;
+    }
+    std::vector<float> taps = parse_kernel(spec);
+    if (taps.empty()) {
+        return Buffer<float>();
+    }
+    const int size = (int)taps.size();
+    Buffer<float> weights(size, HL_PARAM_separable ? 2 : size);
+    weights.for_each_element([&](int i, int j) {
+        weights(i, j) = HL_PARAM_separable ? taps[i] : taps[i] * taps[j];
+    });
+    return weights;
+}
+
+int main(int argc, char **argv) {
+    RunnerOptions options;
+    if (!parse_runner_flags(argc, argv, options) || argc < 3 || argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> [kernel] [options]\n";
+        std::cerr << "Kernel: gaussian:R, box:R (R = 1.." << kMaxRadius
+                  << "), comma-separated taps or, non-separable builds only, KxK rows separated by '/'"
+                  << "; default gaussian:1\n";
+        print_runner_flags(std::cerr);
+        return 1;
+    }
+
+    const char *isa = select_isa(options.isa);
+    if (!isa) {
+        return 1;
+    }
+    runner_log(options) << "Dispatching to the " << isa << " variant\n";
+    install_halide_arena(options);
+
+    std::string kernel = argc >= 4 ? argv[3] : "gaussian:1";
+    Buffer<float> weights = make_weights(kernel);
+    if (!weights.defined()) {
+        std::cerr << "Invalid kernel: " << kernel
+                  << (HL_PARAM_separable && kernel.find('/') != std::string::npos
+                          ? " (full KxK kernels need the non-separable build, stencil_runner.dense)\n"
+                          : "\n");
+        return 1;
+    }
+    const int size = weights.width();
+    runner_log(options) << "Using " << size << "x" << size << " kernel " << kernel
+              << (HL_PARAM_separable ? " (separable)\n" : " (non-separable)\n");
+
+    if (options.batch) {
+        return run_batch(options, "stencil_op", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return stencil_op(input.raw_buffer(), weights.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.stream) {
+        // The kernel radius in halo rows above and below
+        return run_stream(options, "stencil_op", argv[1], argv[2], size / 2, [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return stencil_op(input.raw_buffer(), weights.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    if (options.serve_width > 0) {
+        return run_server(options, "stencil_op", argv[1], argv[2], [&](Buffer<uint8_t> &input, Buffer<uint8_t> &output) {
+            return stencil_op(input.raw_buffer(), weights.raw_buffer(), output.raw_buffer());
+        });
+    }
+
+    // Load the input image (binary PPM is memory-mapped, anything else decoded by STB)
+    BenchStats stats;
+    stats.isa = isa;
+    auto decode_start = BenchClock::now();
+    LoadedImage image;
+    if (!image.load(argv[1])) {
+        std::cerr << "Failed to load input image: " << argv[1] << "\n";
+        return 1;
+    }
+    stats.decode_ms = elapsed_ms(decode_start);
+    int width = image.width(), height = image.height(), channels = image.channels();
+    // --size WxH re-tiles the image for the input-size scaling sweep
+    std::vector<uint8_t> tiled = tile_to_size(options, image.data(), width, height);
+    stats.width = width;
+    stats.height = height;
+
+    std::cout << "Loaded image: " << width << "x" << height
+              << " (" << channels << " channels)\n";
+
+    // Wrap the interleaved pixels directly (no copy); the generator accepts this layout
+    Buffer<uint8_t> input = Buffer<uint8_t>::make_interleaved(tiled.empty() ? image.data() : tiled.data(), width, height, 3);
+
+    // Interleaved output doubles as the encoder input
+    Buffer<uint8_t> output = Buffer<uint8_t>::make_interleaved(width, height, 3);
+
+    std::cout << "Processing image with the stencil...\n";
+
+    int result = run_benchmark(options, stats, [&] {
+        return stencil_op(input.raw_buffer(), weights.raw_buffer(), output.raw_buffer());
+    });
+    if (result != 0) {
+        std::cerr << "Error in stencil\n";
+        return 1;
+    }
+    print_stats(std::cout, stats);
+    if (!options.profile_path.empty() && !write_profile_json(options.profile_path, "stencil_op")) {
+        return 1;
+    }
+
+    // Optional check against a reference image (a golden or the other stencil path)
+    bool matches_reference = options.reference.empty() || check_reference(options, output, stats);
+
+    // Save the output; PNG deflates on worker threads, PPM/PGM/raw skip compression
+    auto encode_start = BenchClock::now();
+    bool success = save_image(argv[2], output);
+    stats.encode_ms = elapsed_ms(encode_start);
+
+    if (!success) {
+        std::cerr << "Failed to save output image\n";
+        return 1;
+    }
+
+    std::cout << "Saved output: " << argv[2] << "\n";
+    print_io_stats(std::cout, stats);
+
+    if (!options.stats_path.empty() && !write_stats_json(options.stats_path, "stencil_op", stats)) {
+        return 1;
+    }
+    return matches_reference ? 0 : 1;
+}
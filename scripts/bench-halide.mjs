@@ -0,0 +1,400 @@
+#!/usr/bin/env node
+// Benchmark driver for the Halide baselines.
+//
+// Runs halide_build/bin/<op>_runner (built by scripts/build-halide.sh) on each
+// example's original image with warm-up and timed iterations, then merges the
+// timing statistics into public/examples/<op>/result.json. The "dsl" entry of
+// result.json is left untouched; "halide" becomes the median pipeline time.
+//
+// Variants are recorded under "halide_variants": the default runner with its
+// multitarget dispatch capped to every CPU variant the host supports (--isa), and
+// every schedule variant runner (<op>_runner.<schedule>) that was built, and
+// every algorithm variant (<op>_runner.<variant>, e.g. fixed-point Canny). For the
+// "pipeline" operator chain that variant is the staged build, so the fused/staged
+// speedup lands next to the fused headline number. Grayscale and Canny also have a
+// single-channel "mono" build, recorded under group "output", that writes 8-bit gray
+// instead of replicating the result to RGB. The "stencil" generator is also run over a
+// range of kernel radii, "brightness" over brightness/contrast/gamma settings (the
+// first one takes the saturating-add path, the others the LUT), "bilateral" over
+// spatial/range sigmas and the large-radius "gaussian" over sigmas 2 to 50.
+//
+// Grayscale and blur also have batched 4-D generators. Their runners are run with
+// --batch --pack on the original cut into thumbnails (PACKED_TILES, the original listed
+// PACKED_COPIES times), and group "packed" records images/s for one call per thumbnail
+// next to one call for all of them.
+//
+// If <op>_runner.profile (built with Halide's profiler) exists, its per-stage
+// breakdown is written to public/examples/<op>/profile.json.
+//
+// Algorithm variants are checked against the default runner's output with
+// --reference; a variant outside its tolerance is reported and makes the driver
+// exit non-zero after all operators have run.
+//
+// --scaling adds a thread-scaling sweep under "halide_scaling": HL_NUM_THREADS
+// runs over 1, 2, 4, ... up to the core count. Strong scaling times each input
+// size from 720p to 8K (the original mirror-tiled with --size) at every thread
+// count. Weak scaling grows a 720p frame with the thread count so each thread
+// keeps the same number of pixels. Scaling runs use 1 warm-up and
+// --scaling-iterations timed runs (default 5).
+//
+// Usage: node scripts/bench-halide.mjs [--warmup N] [--iterations N]
+//          [--no-isa-sweep] [--no-schedule-sweep]
+//          [--scaling] [--scaling-iterations N] [op ...]
+
+import { execFileSync } from "node:child_process";
+import { copyFileSync, existsSync, mkdirSync, readFileSync, writeFileSync } from "node:fs";
+import { availableParallelism } from "node:os";
+import path from "node:path";
+import {
+  OPERATORS,
+  buildDir,
+  examplesDir,
+  findOriginal,
+  runnerPath,
+} from "./halide-examples.mjs";
+
+const outDir = path.join(buildDir, "out");
+
+const ISA_VARIANTS = ["sse41", "avx2", "avx512"];
+const SCHEDULE_VARIANTS = ["mullapudi2016", "li2018", "adams2019", "manual"];
+// Generator-parameter variants built by build-halide.sh (PARAM_VARIANTS) and the
+// tolerance each must meet against the default runner's output
+const ALGORITHM_VARIANTS = {
+  canny: [
+    { name: "fixed", tolerance: ["--max-mismatch", "0.01"] },
+    { name: "nms_ratio", tolerance: ["--max-mismatch", "0.01"] },
+    { name: "mono", group: "output", tolerance: [] },
+  ],
+  // One gray channel instead of three equal ones; the reference is read back as gray,
+  // so it must match exactly
+  grayscale: [{ name: "mono", group: "output", tolerance: [] }],
+  // Same chain with every stage materialized over the whole frame; must match exactly
+  pipeline: [{ name: "staged", tolerance: [] }],
+  // Full 2-D kernel instead of two 1-D passes; differs only by float rounding
+  stencil: [{ name: "dense", tolerance: ["--min-psnr", "50"] }],
+};
+// Input sizes for strong scaling; weak scaling starts from the first one
+const SCALING_SIZES = [
+  [1280, 720],
+  [1920, 1080],
+  [3840, 2160],
+  [7680, 4320],
+];
+// Thumbnail size for the packed-batch comparison, and how many copies of the original
+// are cut into thumbnails
+const PACKED_TILES = { grayscale: "256x256", blur: "256x256" };
+const PACKED_COPIES = 16;
+// Positional runner arguments swept for the default runner; each entry is one
+// space-separated argument list, recorded under the given group
+const ARGUMENT_SWEEP = {
+  stencil: {
+    group: "kernel",
+    args: [1, 2, 3, 4, 5, 6, 7].map((radius) => `gaussian:${radius}`),
+  },
+  brightness: { group: "adjust", args: ["0.2", "0.1 1.3", "0 1 2.2", "0.1 1.2 0.8"] },
+  // Spatial and range sigma; the grid keeps the cost per pixel flat as they grow
+  bilateral: { group: "sigma", args: ["3 10", "5 20", "9 50", "16 20", "32 20"] },
+  // Box-cascade Gaussian; running sums keep the cost flat from sigma 2 to 50
+  gaussian: { group: "sigma", args: ["2", "5", "10", "20", "35", "50"] },
+};
+
+function parseArgs(argv) {
+  const options = {
+    warmup: 5,
+    iterations: 30,
+    isaSweep: true,
+    scheduleSweep: true,
+    scaling: false,
+    scalingIterations: 5,
+    operators: [],
+  };
+  for (let i = 0; i < argv.length; i++) {
+    if (argv[i] === "--warmup") {
+      options.warmup = Number(argv[++i]);
+    } else if (argv[i] === "--iterations") {
+      options.iterations = Number(argv[++i]);
+    } else if (argv[i] === "--no-isa-sweep") {
+      options.isaSweep = false;
+    } else if (argv[i] === "--no-schedule-sweep") {
+      options.scheduleSweep = false;
+    } else if (argv[i] === "--scaling") {
+      options.scaling = true;
+    } else if (argv[i] === "--scaling-iterations") {
+      options.scalingIterations = Number(argv[++i]);
+    } else {
+      options.operators.push(argv[i]);
+    }
+  }
+  if (options.operators.length === 0) {
+    options.operators = OPERATORS;
+  }
+  return options;
+}
+
+// Runs one runner binary with the given extra flags and environment; tag names the
+// output files unless input/output paths are given
+function runRunner(
+  op,
+  options,
+  { variant = "", extraArgs = [], tag = "", env = {}, input = findOriginal(op), output = null } = {}
+) {
+  const runner = runnerPath(op, variant);
+  if (!existsSync(runner)) {
+    throw new Error(`${runner} not found; run scripts/build-halide.sh first`);
+  }
+  const statsPath = path.join(outDir, `${op}${tag}.stats.json`);
+  let passed = true;
+  try {
+      execFileSync(
+      runner,
+      [
+        input,
+        output ?? path.join(outDir, `${op}${tag}.png`),
+        "--warmup",
+        String(options.warmup),
+        "--iterations",
+        String(options.iterations),
+        "--stats",
+        statsPath,
+        ...extraArgs,
+      ],
+      { stdio: "inherit", env: { ...process.env, ...env } }
+    );
+  } catch (error) {
+    // Exit status 1 is a failed --reference check; the stats are still written
+    if (error.status !== 1 || !extraArgs.includes("--reference")) {
+      throw error;
+    }
+    passed = false;
+  }
+  const stats = JSON.parse(readFileSync(statsPath, "utf8"));
+  return passed ? stats : { ...stats, failed: true };
+}
+
+// One entry per CPU variant the host can actually run
+function sweepIsa(op, options) {
+  const variants = [];
+  for (const isa of ISA_VARIANTS) {
+    const stats = runRunner(op, options, {
+      extraArgs: ["--isa", isa],
+      tag: `.${isa}`,
+    });
+    if (stats.isa !== isa) {
+      console.log(`${op}: host has no ${isa}, skipping`);
+      continue;
+    }
+    variants.push({ group: "isa", name: isa, ...stats });
+  }
+  return variants;
+}
+
+// One entry per schedule variant runner that build-halide.sh produced
+function sweepSchedules(op, options) {
+  const variants = [];
+  for (const schedule of SCHEDULE_VARIANTS) {
+    if (!existsSync(runnerPath(op, schedule))) {
+      continue;
+    }
+    const stats = runRunner(op, options, {
+      variant: schedule,
+      tag: `.${schedule}`,
+    });
+    variants.push({ group: "schedule", name: schedule, ...stats });
+  }
+  return variants;
+}
+
+// One entry per argument list the runner is given (stencil radii 1-3 hit the
+// specialized paths)
+function sweepArguments(op, options) {
+  const sweep = ARGUMENT_SWEEP[op];
+  const variants = [];
+  for (const args of sweep?.args ?? []) {
+    const stats = runRunner(op, options, {
+      extraArgs: args.split(" "),
+      tag: `.${args.replace(/[^\w.]+/g, "_")}`,
+    });
+    variants.push({ group: sweep.group, name: args, ...stats });
+  }
+  return variants;
+}
+
+// One entry per algorithm variant, compared against the default runner's output
+function sweepAlgorithms(op, options) {
+  const variants = [];
+  for (const { name, group = "algorithm", tolerance } of ALGORITHM_VARIANTS[op] ?? []) {
+    if (!existsSync(runnerPath(op, name))) {
+      continue;
+    }
+    const stats = runRunner(op, options, {
+      variant: name,
+      extraArgs: ["--reference", path.join(outDir, `${op}.png`), ...tolerance],
+      tag: `.${name}`,
+    });
+    variants.push({ group, name, ...stats });
+  }
+  return variants;
+}
+
+// Per-thumbnail calls against one packed call per size, on the same thumbnails
+function sweepPacked(op, options) {
+  const tile = PACKED_TILES[op];
+  if (!tile) {
+    return [];
+  }
+  const manifest = path.join(outDir, `${op}.packed.txt`);
+  writeFileSync(manifest, Array(PACKED_COPIES).fill(findOriginal(op)).join("\n") + "\n");
+  const stats = runRunner(op, options, {
+    extraArgs: ["--batch", "--pack", "--tile", tile],
+    tag: ".packed",
+    input: manifest,
+    output: path.join(outDir, `${op}.packed`),
+  });
+  const entry = (name, timing) => ({
+    group: "packed",
+    name: `${tile} ${name}`,
+    images: stats.images,
+    threads: stats.threads,
+    ...timing,
+  });
+  return [entry("per-image calls", stats.loop), entry("packed", stats.packed)];
+}
+
+// 1, 2, 4, ... up to the core count, which is always included
+function threadCounts() {
+  const cores = availableParallelism();
+  const counts = [];
+  for (let n = 1; n < cores; n *= 2) {
+    counts.push(n);
+  }
+  counts.push(cores);
+  return counts;
+}
+
+// Strong scaling per input size and weak scaling from the smallest size. Speedup
+// is against the single-thread run of the same curve; efficiency is speedup over
+// threads for strong scaling and t(1) / t(N) for weak scaling.
+function sweepScaling(op, options) {
+  const threads = threadCounts();
+  const runOptions = { ...options, warmup: 1, iterations: options.scalingIterations };
+  const time = (n, width, height) =>
+    runRunner(op, runOptions, {
+      extraArgs: ["--size", `${width}x${height}`],
+      tag: `.t${n}.${width}x${height}`,
+      env: { HL_NUM_THREADS: String(n) },
+    });
+  const point = (n, stats, base) => ({
+    threads: n,
+    width: stats.width,
+    height: stats.height,
+    median_ms: stats.median_ms,
+    mpix_per_s: stats.mpix_per_s,
+    speedup: base.median_ms / stats.median_ms,
+  });
+
+  const strong = SCALING_SIZES.map(([width, height]) => {
+    const runs = threads.map((n) => time(n, width, height));
+    return {
+      size: `${width}x${height}`,
+      points: runs.map((stats, i) => {
+        const p = point(threads[i], stats, runs[0]);
+        return { ...p, efficiency: p.speedup / threads[i] };
+      }),
+    };
+  });
+
+  const [baseWidth, baseHeight] = SCALING_SIZES[0];
+  const weakRuns = threads.map((n) => {
+    // Same pixels per thread; keep the aspect ratio and an even size
+    const scale = Math.sqrt(n);
+    return time(n, 2 * Math.round((baseWidth * scale) / 2), 2 * Math.round((baseHeight * scale) / 2));
+  });
+  const weak = {
+    size: `${baseWidth}x${baseHeight}`,
+    points: weakRuns.map((stats, i) => {
+      // Scaled speedup: N times the work in t(N) instead of t(1)
+      const p = point(threads[i], stats, weakRuns[0]);
+      return { ...p, efficiency: p.speedup, speedup: p.speedup * threads[i] };
+    }),
+  };
+  return { cores: availableParallelism(), threads, strong, weak };
+}
+
+// Per-Func time, peak memory and thread utilisation from the profiler build
+function profileStages(op, options) {
+  if (!existsSync(runnerPath(op, "profile"))) {
+    return;
+  }
+  const profilePath = path.join(outDir, `${op}.profile.json`);
+  runRunner(op, options, {
+    variant: "profile",
+    extraArgs: ["--profile", profilePath],
+    tag: ".profile",
+  });
+  copyFileSync(profilePath, path.join(examplesDir, op, "profile.json"));
+}
+
+function updateResult(op, stats, variants, scaling) {
+  const resultPath = path.join(examplesDir, op, "result.json");
+  const result = existsSync(resultPath)
+    ? JSON.parse(readFileSync(resultPath, "utf8"))
+    : {};
+  result.halide = stats.median_ms.toFixed(2);
+  result.halide_stats = stats;
+  result.halide_variants = variants;
+  if (scaling) {
+    result.halide_scaling = scaling;
+  }
+  writeFileSync(resultPath, JSON.stringify(result, null, 2) + "\n");
+}
+
+const options = parseArgs(process.argv.slice(2));
+mkdirSync(outDir, { recursive: true });
+const failures = [];
+for (const op of options.operators) {
+  console.log(`== ${op}`);
+  const stats = runRunner(op, options);
+  const variants = [
+    ...(options.isaSweep ? sweepIsa(op, options) : []),
+    ...(options.scheduleSweep ? sweepSchedules(op, options) : []),
+    ...sweepAlgorithms(op, options),
+    ...sweepArguments(op, options),
+    ...sweepPacked(op, options),
+  ];
+  const scaling = options.scaling ? sweepScaling(op, options) : null;
+  updateResult(op, stats, variants, scaling);
+  profileStages(op, options);
+  console.log(
+    `${op}: median ${stats.median_ms.toFixed(2)} ms, p95 ${stats.p95_ms.toFixed(2)} ms, ` +
+      `${stats.mpix_per_s.toFixed(1)} MP/s (${stats.isa})`
+  );
+  for (const variant of variants) {
+    const accuracy =
+      variant.mismatch !== undefined
+        ? `, ${(variant.mismatch * 100).toFixed(2)}% differ, PSNR ${variant.psnr.toFixed(1)} dB` +
+          (variant.failed ? " (FAILED)" : "")
+        : "";
+    const throughput =
+      variant.images_per_s !== undefined
+        ? `${variant.images_per_s.toFixed(0)} images/s`
+        : `${variant.mpix_per_s.toFixed(1)} MP/s`;
+    console.log(
+      `  ${variant.group}=${variant.name}: median ${variant.median_ms.toFixed(2)} ms, ` +
+        `${throughput}${accuracy}`
+    );
+    if (variant.failed) {
+      failures.push(`${op} ${variant.name}`);
+    }
+  }
+  for (const curve of scaling?.strong ?? []) {
+    const last = curve.points[curve.points.length - 1];
+    console.log(
+      `  scaling ${curve.size}: ${last.speedup.toFixed(2)}x on ${last.threads} threads ` +
+        `(${(last.efficiency * 100).toFixed(0)}% efficiency)`
+    );
+  }
+}
+if (failures.length > 0) {
+  console.error(`Outside tolerance: ${failures.join(", ")}`);
+  process.exit(1);
+}
@@ -0,0 +1,281 @@
+#!/usr/bin/env bash
+# Build the Halide baselines shown on the benchmark page.
+#
+# Each public/examples/<op>/<op>_halide.cpp holds a "// Generator.cpp" and a
+# "// Runner.cpp" section. They are split into halide_build/<op>/src, the
+# generator is compiled and run ahead-of-time once per schedule variant, and the
+# runner is linked against each resulting static library as
+# halide_build/bin/<op>_runner.<schedule>. halide_build/bin/<op>_runner is the
+# first schedule in HL_SCHEDULES. Generator-parameter variants (PARAM_VARIANTS,
+# e.g. the fixed-point Canny) are built with that schedule as <op>_runner.<variant>,
+# and so is <op>_runner.profile, with Halide's sampling profiler compiled in for the
+# build host only (runners take --profile FILE for a per-Func breakdown).
+#
+# <op>_runner.jit links the generator itself instead of AOT libraries and compiles
+# each pipeline on first use for the host, caching the result in
+# halide_build/jit-cache keyed by the generator source, params, target and Halide
+# version (public/examples/common/halide_jit.h). HL_JIT_PARAMS="k=v ..." tries new
+# generator params without rebuilding.
+#
+# Autoscheduled builds are made once per size class (HL_SIZE_CLASSES), each with
+# estimates for that frame size, and linked into one runner that picks the class
+# nearest the input size at run time (public/examples/common/halide_size_classes.h).
+#
+# Usage: HALIDE_ROOT=/opt/halide scripts/build-halide.sh [op ...]
+#
+# Environment:
+#   HALIDE_ROOT       Halide install (include/, lib/, share/Halide/tools/)
+#   HL_TARGET         generator target (default on x86-64: AVX-512, AVX2 and SSE4.1
+#                     variants in one library, dispatched on CPUID at runtime;
+#                     elsewhere: host)
+#   HL_SCHEDULES      schedule variants to build (default: Mullapudi2016 Li2018
+#                     Adams2019 manual); "manual" runs without an autoscheduler so
+#                     the generator's hand-written schedule applies
+#   HL_SIZE_CLASSES   <class>:<width>x<height> frame sizes autoscheduled builds are
+#                     tuned for (default: thumb:320x240 hd:1920x1080 uhd:3840x2160
+#                     mp12:4000x3000); empty for a single 1920x1080 build
+#   CXX               C++ compiler (default: c++)
+#
+# The runners include ../../../runtime/stb_image.h, so the stb headers are
+# expected in runtime/ at the repository root. They also link zlib (-lz) for the
+# multi-threaded PNG encoder (public/examples/common/halide_deflate.h).
+set -euo pipefail
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD="$ROOT/halide_build"
+HALIDE_ROOT=${HALIDE_ROOT:?set HALIDE_ROOT to a Halide install}
+
+# One library per generator with AVX-512, AVX2 and SSE4.1 variants. Halide's multitarget
+# wrapper tries them in order and runs the first one the CPU supports; the runners'
+# --isa flag caps the choice (see public/examples/common/halide_dispatch.h).
+default_target() {
+    local os
+    case "$(uname -s)" in
+        Linux) os=linux ;;
+        Darwin) os=osx ;;
+        *) echo host; return ;;
+    esac
+    if [ "$(uname -m)" = x86_64 ]; then
+        local base="x86-64-$os"
+        echo "$base-sse41-avx-f16c-fma-avx2-avx512-avx512_skylake,$base-sse41-avx-f16c-fma-avx2,$base-sse41"
+    else
+        echo host
+    fi
+}
+HL_TARGET=${HL_TARGET:-$(default_target)}
+HL_SCHEDULES=${HL_SCHEDULES:-Mullapudi2016 Li2018 Adams2019 manual}
+HL_SIZE_CLASSES=${HL_SIZE_CLASSES-thumb:320x240 hd:1920x1080 uhd:3840x2160 mp12:4000x3000}
+CXX=${CXX:-c++}
+
+CXXFLAGS=(-std=c++17 -O3 -I"$HALIDE_ROOT/include" -I"$ROOT/public/examples/common")
+LDFLAGS=(-L"$HALIDE_ROOT/lib" -lHalide -lpthread -ldl -lz -Wl,-rpath,"$HALIDE_ROOT/lib")
+GENGEN="$HALIDE_ROOT/share/Halide/tools/GenGen.cpp"
+
+# Example directory -> registered generator name (also the AOT function name)
+declare -A GENERATORS=(
+    [bilateral]=bilateral_grid
+    [blur]=gaussian3x3_auto
+    [brightness]=brightness_auto
+    [canny]=canny_auto
+    [gaussian]=box_gaussian
+    [grayscale]=grayscale_auto
+    [pipeline]=pipeline_fused
+    [stencil]=stencil_op
+)
+
+# Examples with a batched 4-D (x, y, c, n) generator, built next to the main one with the
+# same schedule and params and linked into the same runner for --batch --pack. It is tuned
+# for thumbnail batches (its own estimates), so it gets no size classes.
+declare -A BATCH_GENERATORS=(
+    [blur]=gaussian3x3_batch
+    [grayscale]=grayscale_batch
+)
+
+# Examples built with a fixed schedule list instead of HL_SCHEDULES. The operator chain
+# compares its fused and staged forms, which only the hand-written schedule expresses.
+declare -A OP_SCHEDULES=(
+    [pipeline]=manual
+)
+
+# Split an example file into <dir>/Generator.cpp and <dir>/Runner.cpp
+split_sections() {
+    awk -v dir="$2" '/^\/\/ [A-Za-z_]+\.cpp$/ { out = dir "/" $2; next } out { print > out }' "$1"
+}
+
+autoscheduler_plugin() {
+    echo "$HALIDE_ROOT/lib/libautoschedule_$(echo "$1" | tr '[:upper:]' '[:lower:]').so"
+}
+
+# Generator arguments selecting a schedule variant
+schedule_args() {
+    if [ "$1" != manual ]; then
+        echo "-p $(autoscheduler_plugin "$1") autoscheduler=$1"
+    fi
+}
+
+# Generator-parameter variants per example, each built with the first schedule as
+# halide_build/bin/<op>_runner.<variant>. Entries are <variant>:<param=value>[,...]; the
+# runner is compiled with -DHL_PARAM_<param>=<value> for each so it can match the build
+declare -A PARAM_VARIANTS=(
+    [canny]="fixed:fixed_point=true nms_ratio:nms_mode=ratio mono:output_channels=1"
+    [grayscale]="mono:output_channels=1"
+    [pipeline]="staged:staged=true"
+    [stencil]="dense:separable=false"
+)
+
+# Every target of a (multi)target string with the given feature added
+with_feature() {
+    local target=$1 feature=$2
+    echo "${target//,/-$feature,}-$feature"
+}
+
+# Writes <out>/<name>_aot.h defining <name>(input, ...) to call <name>_<class> for the
+# size class nearest the input (halide_size_classes.h)
+write_size_dispatch() {
+    local name=$1 out=$2 entry size i=0
+    {
+        echo "// Generated by scripts/build-halide.sh: $name dispatching on the input size"
+        echo "#pragma once"
+        echo "#include \"halide_size_classes.h\""
+        for entry in $HL_SIZE_CLASSES; do
+            echo "#include \"${name}_${entry%%:*}.h\""
+        done
+        echo
+        echo "template <typename... Args>"
+        echo "inline int $name(halide_buffer_t *input, Args... args) {"
+        echo "    static const SizeClass classes[] = {"
+        for entry in $HL_SIZE_CLASSES; do
+            size=${entry#*:}
+            echo "        {\"${entry%%:*}\", ${size%x*}, ${size#*x}},"
+        done
+        echo "    };"
+        echo "    switch (nearest_size_class(classes, input)) {"
+        for entry in $HL_SIZE_CLASSES; do
+            echo "    case $i: return ${name}_${entry%%:*}(input, args...);"
+            i=$((i + 1))
+        done
+        echo "    default: return -1;"
+        echo "    }"
+        echo "}"
+    } > "$out/${name}_aot.h"
+}
+
+# Writes <out>/<name>_aot.h defining <name>(args...) to call the JIT-compiled pipeline
+write_jit_dispatch() {
+    local name=$1 out=$2
+    {
+        echo "// Generated by scripts/build-halide.sh: $name compiled on first use (halide_jit.h)"
+        echo "#pragma once"
+        echo "#include \"halide_jit.h\""
+        echo
+        echo "template <typename... Args>"
+        echo "inline int $name(Args... args) {"
+        echo "    static JitPipeline &pipeline = jit_pipeline(\"$name\");"
+        echo "    return pipeline(args...);"
+        echo "}"
+    } > "$out/${name}_aot.h"
+}
+
+# build_jit <op>: the runner with the generator linked in and one exported runtime that
+# the pipelines it compiles (built with no_runtime) bind to when loaded
+build_jit() {
+    local op=$1
+    local name=${GENERATORS[$op]} batch=${BATCH_GENERATORS[$op]:-} src="$BUILD/$op/src" out="$BUILD/$op/jit"
+    local fn
+    mkdir -p "$out"
+
+    echo "== $op: jit (host)"
+    "$BUILD/$op/$op.generator" -r halide_runtime -o "$out" -e object target=host
+    for fn in $name $batch; do
+        write_jit_dispatch "$fn" "$out"
+    done
+    "$CXX" "${CXXFLAGS[@]}" -fno-rtti -c "$src/Generator.cpp" -o "$out/Generator.o"
+    "$CXX" "${CXXFLAGS[@]}" -I"$out" \
+        -DHL_JIT_SOURCE_HASH="\"$(sha256sum "$src/Generator.cpp" | cut -c1-16)\"" \
+        -DHL_JIT_CACHE_DIR="\"$BUILD/jit-cache\"" \
+        -DHL_JIT_PLUGIN_DIR="\"$HALIDE_ROOT/lib\"" \
+        -DHL_JIT_CXX="\"$CXX\"" \
+        "$src/Runner.cpp" "$out/Generator.o" "$out/halide_runtime.o" "${LDFLAGS[@]}" -rdynamic \
+        -o "$BUILD/bin/${op}_runner.jit"
+}
+
+# build_variant <op> <variant> <schedule> <target> [generator params...]
+build_variant() {
+    local op=$1 variant=$2 schedule=$3 target=$4
+    shift 4
+    local name=${GENERATORS[$op]} src="$BUILD/$op/src" out="$BUILD/$op/$variant"
+    local defines=() libs=() param entry size
+    for param in "$@"; do
+        defines+=("-DHL_PARAM_${param%%=*}=${param#*=}")
+    done
+    if [[ $target == *-profile* ]]; then
+        defines+=(-DHL_PROFILER)
+    fi
+    mkdir -p "$out"
+
+    echo "== $op: $variant ($schedule schedule${*:+, $*})"
+    # The hand-written schedule ignores estimates, and the profiler reports per pipeline
+    # name, so both get a single library
+    if [ "$schedule" != manual ] && [[ $target != *-profile* ]] && [ -n "$HL_SIZE_CLASSES" ]; then
+        for entry in $HL_SIZE_CLASSES; do
+            size=${entry#*:}
+            # shellcheck disable=SC2046
+            "$BUILD/$op/$op.generator" -g "$name" -f "${name}_${entry%%:*}" -n "${name}_${entry%%:*}" -o "$out" \
+                -e static_library,h $(schedule_args "$schedule") target="$target" "$@" \
+                estimate_width="${size%x*}" estimate_height="${size#*x}"
+            libs+=("$out/${name}_${entry%%:*}.a")
+        done
+        write_size_dispatch "$name" "$out"
+    else
+        # shellcheck disable=SC2046
+        "$BUILD/$op/$op.generator" -g "$name" -f "$name" -n "${name}_aot" -o "$out" \
+            -e static_library,h $(schedule_args "$schedule") target="$target" "$@"
+        libs=("$out/${name}_aot.a")
+    fi
+    local batch=${BATCH_GENERATORS[$op]:-}
+    if [ -n "$batch" ]; then
+        # The main library already carries the Halide runtime
+        # shellcheck disable=SC2046
+        "$BUILD/$op/$op.generator" -g "$batch" -f "$batch" -n "${batch}_aot" -o "$out" \
+            -e static_library,h $(schedule_args "$schedule") target="$(with_feature "$target" no_runtime)" "$@"
+        libs+=("$out/${batch}_aot.a")
+    fi
+    "$CXX" "${CXXFLAGS[@]}" "${defines[@]}" -I"$out" "$src/Runner.cpp" "${libs[@]}" "${LDFLAGS[@]}" \
+        -o "$BUILD/bin/${op}_runner.$variant"
+}
+
+build_op() {
+    local op=$1
+    local name=${GENERATORS[$op]:?unknown example: $op}
+    local src="$BUILD/$op/src"
+    local schedules=(${OP_SCHEDULES[$op]:-$HL_SCHEDULES})
+    mkdir -p "$src" "$BUILD/bin"
+
+    split_sections "$ROOT/public/examples/$op/${op}_halide.cpp" "$src"
+
+    echo "== $op: generator $name ($HL_TARGET)"
+    "$CXX" "${CXXFLAGS[@]}" -fno-rtti "$src/Generator.cpp" "$GENGEN" "${LDFLAGS[@]}" -o "$BUILD/$op/$op.generator"
+
+    for schedule in "${schedules[@]}"; do
+        build_variant "$op" "$(echo "$schedule" | tr '[:upper:]' '[:lower:]')" "$schedule" "$HL_TARGET"
+    done
+    cp "$BUILD/bin/${op}_runner.$(echo "${schedules[0]}" | tr '[:upper:]' '[:lower:]')" "$BUILD/bin/${op}_runner"
+
+    for entry in ${PARAM_VARIANTS[$op]:-}; do
+        local params=${entry#*:}
+        # shellcheck disable=SC2086
+        build_variant "$op" "${entry%%:*}" "${schedules[0]}" "$HL_TARGET" ${params//,/ }
+    done
+
+    # One target, not the multitarget list: a multitarget build registers each profiled
+    # sub-pipeline as <name>_<target suffix>, so the runner's lookup by <name> would find nothing
+    build_variant "$op" profile "${schedules[0]}" host-profile
+    build_jit "$op"
+}
+
+if [ $# -eq 0 ]; then
+    set -- "${!GENERATORS[@]}"
+fi
+for op in "$@"; do
+    build_op "$op"
+done
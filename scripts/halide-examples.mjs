@@ -0,0 +1,56 @@
+// Example operators and build paths shared by the Halide scripts (bench-halide.mjs,
+// serve-halide.mjs).
+
+import { existsSync, readdirSync } from "node:fs";
+import path from "node:path";
+import { fileURLToPath } from "node:url";
+
+export const root = path.resolve(path.dirname(fileURLToPath(import.meta.url)), "..");
+export const examplesDir = path.join(root, "public", "examples");
+export const buildDir = path.join(root, "halide_build");
+
+export const OPERATORS = [
+  "grayscale",
+  "brightness",
+  "blur",
+  "canny",
+  "bilateral",
+  "gaussian",
+  "pipeline",
+  "stencil",
+];
+// Examples without their own original image borrow another example's
+export const INPUT_FROM = {
+  bilateral: "brightness",
+  gaussian: "blur",
+  pipeline: "canny",
+  stencil: "blur",
+};
+
+export function findOriginal(op) {
+  const source = INPUT_FROM[op] ?? op;
+  for (const ext of ["png", "jpg", "jpeg"]) {
+    const file = path.join(examplesDir, source, `original.${ext}`);
+    if (existsSync(file)) {
+      return file;
+    }
+  }
+  throw new Error(`No original image in public/examples/${source}`);
+}
+
+export function runnerPath(op, variant = "") {
+  return path.join(buildDir, "bin", `${op}_runner${variant ? "." + variant : ""}`);
+}
+
+// Variant suffixes of every <op>_runner.<variant> that build-halide.sh produced
+export function builtVariants(op) {
+  const bin = path.join(buildDir, "bin");
+  if (!existsSync(bin)) {
+    return [];
+  }
+  const prefix = `${op}_runner.`;
+  return readdirSync(bin)
+    .filter((file) => file.startsWith(prefix))
+    .map((file) => file.slice(prefix.length))
+    .sort();
+}
@@ -0,0 +1,261 @@
+#!/usr/bin/env node
+// Accuracy and performance regression suite for the Halide baselines.
+//
+// Runs every case in CASES (the default runner of each example plus the variants and
+// arguments most likely to drift) on a fixed corpus, the original images committed
+// under public/examples, and checks two things:
+//
+//   accuracy  the output against a stored golden in regress/halide/goldens, through the
+//             runners' --reference check: Canny's edge map must match exactly, every
+//             other output must stay above --min-psnr (default 45 dB)
+//   speed     the timing statistics against regress/halide/baseline.json: a case
+//             regresses when its median is more than --tolerance (default 10%) above
+//             the baseline median and even its fastest run is slower than the baseline
+//             median, so a single noisy run does not fail the suite. Cases timed on a
+//             different ISA or thread count than the baseline are reported, not compared.
+//
+// Nothing passes unchecked: a case without a golden, a golden the runner could not compare
+// against, or a case without a baseline entry fails (UNCHECKED) until --update records
+// them. The examples' processed.png files are the web DSL's outputs, not Halide's, so they
+// are never used as goldens. A runner that crashes or writes no stats fails its case; the
+// rest still run.
+//
+// Exits non-zero if any case fails. --update rewrites the goldens and the baseline from
+// the current build instead (for the listed operators only, if any are given); commit
+// them together with the change that moved them.
+//
+// Usage: node scripts/regress-halide.mjs [--update] [--tolerance F] [--min-psnr DB]
+//          [--warmup N] [--iterations N] [--no-timing] [op ...]
+
+import { execFileSync } from "node:child_process";
+import { existsSync, mkdirSync, readFileSync, rmSync, writeFileSync } from "node:fs";
+import path from "node:path";
+import {
+  INPUT_FROM,
+  OPERATORS,
+  buildDir,
+  findOriginal,
+  root,
+  runnerPath,
+} from "./halide-examples.mjs";
+
+const regressDir = path.join(root, "regress", "halide");
+const goldenDir = path.join(regressDir, "goldens");
+const baselinePath = path.join(regressDir, "baseline.json");
+const outDir = path.join(buildDir, "regress");
+
+// Cases per example: a runner variant (build-halide.sh PARAM_VARIANTS) and/or
+// positional arguments; {} is the default runner with default arguments
+const CASES = {
+  grayscale: [{}, { variant: "mono" }],
+  brightness: [{}, { args: "0.1 1.2 0.8" }],
+  blur: [{}],
+  canny: [{}, { variant: "fixed" }, { variant: "nms_ratio" }],
+  bilateral: [{}, { args: "9 50" }],
+  gaussian: [{}, { args: "35" }],
+  pipeline: [{}, { variant: "staged" }],
+  stencil: [
+    {},
+    { args: "gaussian:5" },
+    { variant: "dense" },
+    { variant: "dense", args: "1,2,1/2,8,2/1,2,1" },
+  ],
+};
+// Binary edge maps: any differing pixel is a regression
+const EXACT_OUTPUTS = new Set(["canny"]);
+
+function parseArgs(argv) {
+  const options = {
+    update: false,
+    tolerance: 0.1,
+    minPsnr: 45,
+    warmup: 5,
+    iterations: 30,
+    timing: true,
+    operators: [],
+  };
+  for (let i = 0; i < argv.length; i++) {
+    if (argv[i] === "--update") {
+      options.update = true;
+    } else if (argv[i] === "--tolerance") {
+      options.tolerance = Number(argv[++i]);
+    } else if (argv[i] === "--min-psnr") {
+      options.minPsnr = Number(argv[++i]);
+    } else if (argv[i] === "--warmup") {
+      options.warmup = Number(argv[++i]);
+    } else if (argv[i] === "--iterations") {
+      options.iterations = Number(argv[++i]);
+    } else if (argv[i] === "--no-timing") {
+      options.timing = false;
+    } else {
+      options.operators.push(argv[i]);
+    }
+  }
+  if (options.operators.length === 0) {
+    options.operators = OPERATORS;
+  }
+  return options;
+}
+
+// The examples' own originals; examples that borrow an image add nothing new
+function corpus() {
+  return OPERATORS.filter((op) => !INPUT_FROM[op]).map((op) => findOriginal(op));
+}
+
+function caseName(op, { variant = "", args = "" }, image) {
+  const stem = path.basename(path.dirname(image));
+  return (
+    op +
+    (variant ? `.${variant}` : "") +
+    (args ? `_${args.replace(/[^\w.]+/g, "_")}` : "") +
+    `@${stem}`
+  );
+}
+
+// Runs one case; with a golden the runner checks its output against it and still
+// writes the stats when the check fails. Throws if the runner fails any other way.
+function runCase(op, testCase, image, name, golden, options) {
+  const output = options.update
+    ? path.join(goldenDir, `${name}.png`)
+    : path.join(outDir, `${name}.png`);
+  const statsPath = path.join(outDir, `${name}.stats.json`);
+  rmSync(statsPath, { force: true });
+  const compare = options.update
+    ? []
+    : [
+        "--reference",
+        golden,
+        ...(EXACT_OUTPUTS.has(op)
+          ? ["--max-mismatch", "0"]
+          : ["--min-psnr", String(options.minPsnr)]),
+      ];
+  let passed = true;
+  try {
+    execFileSync(
+      runnerPath(op, testCase.variant),
+      [
+        image,
+        output,
+        ...(testCase.args ? testCase.args.split(" ") : []),
+        "--warmup",
+        String(options.warmup),
+        "--iterations",
+        String(options.iterations),
+        "--stats",
+        statsPath,
+        ...compare,
+      ],
+      { stdio: ["ignore", "ignore", "inherit"] }
+    );
+  } catch (error) {
+    if (error.status !== 1 || compare.length === 0 || !existsSync(statsPath)) {
+      throw new Error(error.signal ? `killed by ${error.signal}` : `exit status ${error.status}`);
+    }
+    passed = false;
+  }
+  if (!existsSync(statsPath)) {
+    throw new Error("no stats written");
+  }
+  return { stats: JSON.parse(readFileSync(statsPath, "utf8")), passed };
+}
+
+// Timing verdict against the baseline entry, with a note for the report
+function compareTiming(stats, base, options) {
+  if (!base) {
+    return { ok: false, note: "UNCHECKED: no baseline entry (run with --update)" };
+  }
+  if (base.isa !== stats.isa || base.threads !== stats.threads) {
+    return {
+      ok: true,
+      note: `baseline from ${base.isa}/${base.threads} threads, not compared`,
+    };
+  }
+  const change = stats.median_ms / base.median_ms - 1;
+  const slower = change > options.tolerance && stats.min_ms > base.median_ms;
+  return {
+    ok: !slower,
+    note: `${change >= 0 ? "+" : ""}${(change * 100).toFixed(1)}% vs ${base.median_ms.toFixed(2)} ms`,
+  };
+}
+
+const options = parseArgs(process.argv.slice(2));
+mkdirSync(outDir, { recursive: true });
+mkdirSync(goldenDir, { recursive: true });
+const baseline = existsSync(baselinePath)
+  ? JSON.parse(readFileSync(baselinePath, "utf8"))
+  : { cases: {} };
+const images = corpus();
+const failures = [];
+
+for (const op of options.operators) {
+  for (const testCase of CASES[op] ?? [{}]) {
+    if (!existsSync(runnerPath(op, testCase.variant))) {
+      const runner = op + (testCase.variant ? `.${testCase.variant}` : "");
+      console.log(`${runner}: runner not built, skipping`);
+      continue;
+    }
+    for (const image of images) {
+      const name = caseName(op, testCase, image);
+      const golden = path.join(goldenDir, `${name}.png`);
+      if (!options.update && !existsSync(golden)) {
+        console.log(`${name}: UNCHECKED, no golden (run with --update)`);
+        failures.push(`${name} (no golden)`);
+        continue;
+      }
+      let result;
+      try {
+        result = runCase(op, testCase, image, name, golden, options);
+      } catch (error) {
+        console.log(`${name}: RUNNER FAILED (${error.message})`);
+        failures.push(`${name} (runner: ${error.message})`);
+        continue;
+      }
+      const { stats } = result;
+      let { passed } = result;
+      if (options.update) {
+        baseline.cases[name] = {
+          isa: stats.isa,
+          threads: stats.threads,
+          min_ms: stats.min_ms,
+          median_ms: stats.median_ms,
+          p95_ms: stats.p95_ms,
+          mpix_per_s: stats.mpix_per_s,
+        };
+        console.log(`${name}: golden and baseline updated (median ${stats.median_ms.toFixed(2)} ms)`);
+        continue;
+      }
+
+      // No comparison in the stats: the golden could not be read or is another size
+      const compared = stats.mismatch !== undefined;
+      const accuracy = compared
+        ? `${(stats.mismatch * 100).toFixed(2)}% differ, PSNR ${stats.psnr.toFixed(1)} dB`
+        : "UNCHECKED: golden not comparable";
+      passed = passed && compared;
+      const timing = options.timing
+        ? compareTiming(stats, baseline.cases[name], options)
+        : { ok: true, note: "timing skipped" };
+      const slower = !timing.ok && !timing.note.startsWith("UNCHECKED");
+      console.log(
+        `${name}: ${passed ? "ok" : compared ? "OUTPUT CHANGED" : "FAILED"} (${accuracy}); ` +
+          `median ${stats.median_ms.toFixed(2)} ms, ${slower ? "SLOWER " : ""}${timing.note}`
+      );
+      if (!passed) {
+        failures.push(`${name} (output: ${accuracy})`);
+      }
+      if (!timing.ok) {
+        failures.push(`${name} (speed: ${timing.note})`);
+      }
+    }
+  }
+}
+
+if (options.update) {
+  writeFileSync(baselinePath, JSON.stringify(baseline, null, 2) + "\n");
+  console.log(`Wrote ${path.relative(root, baselinePath)} and goldens in ${path.relative(root, goldenDir)}`);
+}
+if (failures.length > 0) {
+  console.error(`\n${failures.length} regression(s):\n  ${failures.join("\n  ")}`);
+  process.exit(1);
+} else if (!options.update) {
+  console.log("\nNo regressions");
+}
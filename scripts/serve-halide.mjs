@@ -0,0 +1,232 @@
+#!/usr/bin/env node
+// Local benchmark service for the Halide baselines.
+//
+// Wraps the runners in halide_build/bin (built by scripts/build-halide.sh) so the
+// benchmark page can time them live on this machine instead of reading the static
+// result.json. Listens on 127.0.0.1 only; `npm run dev` proxies /api/halide to it.
+//
+//   GET  /api/halide/operators
+//        [{ op, variants: [...] }] for every operator whose runner is built
+//   POST /api/halide/run?op=blur[&variant=manual][&iterations=30][&warmup=5][&args=...]
+//        Runs the runner once with --warmup/--iterations/--stats. The body is the
+//        input image (PNG, JPEG, BMP or PPM); an empty body uses the example's
+//        original. args holds the runner's positional arguments (e.g. a sigma),
+//        separated by spaces. Responds with { stats, image } where stats is the
+//        runner's --stats JSON and image a data: URL of the PNG output.
+//
+// Runs are queued and executed one at a time so concurrent requests do not skew
+// each other's timings.
+//
+// Only local callers are served: the Host header must name localhost or 127.0.0.1, and a
+// request carrying an Origin must come from the dev server (http://localhost:5173 or
+// http://127.0.0.1:5173 unless --origin is given), so other pages open in the browser
+// cannot start runs.
+//
+// Usage: node scripts/serve-halide.mjs [--port N] [--origin URL ...]
+//          (port default 8787, or HALIDE_SERVE_PORT)
+
+import { execFile } from "node:child_process";
+import { existsSync } from "node:fs";
+import { mkdtemp, readFile, rm, writeFile } from "node:fs/promises";
+import { createServer } from "node:http";
+import { tmpdir } from "node:os";
+import path from "node:path";
+import { OPERATORS, builtVariants, findOriginal, runnerPath } from "./halide-examples.mjs";
+
+const MAX_UPLOAD_BYTES = 64 * 1024 * 1024;
+const MAX_ITERATIONS = 1000;
+const RUN_TIMEOUT_MS = 5 * 60 * 1000;
+// Extensions the runners decode, by upload content type
+const UPLOAD_EXTENSIONS = {
+  "image/png": ".png",
+  "image/jpeg": ".jpg",
+  "image/bmp": ".bmp",
+  "image/x-portable-pixmap": ".ppm",
+};
+
+const LOCAL_HOSTS = new Set(["localhost", "127.0.0.1"]);
+// Vite's default dev server
+const DEV_ORIGINS = ["http://localhost:5173", "http://127.0.0.1:5173"];
+
+function parseArgs(argv) {
+  let port = Number(process.env.HALIDE_SERVE_PORT ?? 8787);
+  const origins = [];
+  for (let i = 0; i < argv.length; i++) {
+    if (argv[i] === "--port") {
+      port = Number(argv[++i]);
+    } else if (argv[i] === "--origin") {
+      origins.push(new URL(argv[++i]).origin);
+    } else {
+      throw new Error(`Unknown argument: ${argv[i]}`);
+    }
+  }
+  return { port, origins: new Set(origins.length > 0 ? origins : DEV_ORIGINS) };
+}
+
+class HttpError extends Error {
+  constructor(status, message) {
+    super(message);
+    this.status = status;
+  }
+}
+
+function sendJson(response, status, body) {
+  response.writeHead(status, { "Content-Type": "application/json" });
+  response.end(JSON.stringify(body));
+}
+
+async function readBody(request) {
+  const chunks = [];
+  let size = 0;
+  for await (const chunk of request) {
+    size += chunk.length;
+    if (size > MAX_UPLOAD_BYTES) {
+      throw new HttpError(413, `Image larger than ${MAX_UPLOAD_BYTES >> 20} MiB`);
+    }
+    chunks.push(chunk);
+  }
+  return Buffer.concat(chunks);
+}
+
+function boundedInt(value, fallback, min, max, name) {
+  if (value === null || value === "") {
+    return fallback;
+  }
+  const number = Number(value);
+  if (!Number.isInteger(number) || number < min || number > max) {
+    throw new HttpError(400, `${name} must be an integer from ${min} to ${max}`);
+  }
+  return number;
+}
+
+// Checks a /api/halide/run query against the built runners; returns the runner
+// invocation it describes
+function parseRunRequest(query) {
+  const op = query.get("op") ?? "";
+  if (!OPERATORS.includes(op) || !existsSync(runnerPath(op))) {
+    throw new HttpError(404, `No runner built for operator "${op}"`);
+  }
+  const variant = query.get("variant") ?? "";
+  if (variant && !builtVariants(op).includes(variant)) {
+    throw new HttpError(404, `No ${op} runner variant "${variant}"`);
+  }
+  // Positional arguments only: anything that looks like a flag is refused
+  const args = (query.get("args") ?? "").split(" ").filter(Boolean);
+  if (args.some((arg) => !/^(-?\d[\d.]*|[\w.:,/]+)$/.test(arg))) {
+    throw new HttpError(400, "args must be numbers or kernel specs separated by spaces");
+  }
+  return {
+    op,
+    variant,
+    args,
+    warmup: boundedInt(query.get("warmup"), 5, 0, MAX_ITERATIONS, "warmup"),
+    iterations: boundedInt(query.get("iterations"), 30, 1, MAX_ITERATIONS, "iterations"),
+  };
+}
+
+function execRunner(runner, args) {
+  return new Promise((resolve, reject) => {
+    execFile(runner, args, { timeout: RUN_TIMEOUT_MS, maxBuffer: 16 * 1024 * 1024 }, (error, stdout, stderr) => {
+      if (error) {
+        const log = `${stdout}${stderr}`.trim().split("\n").slice(-20).join("\n");
+        reject(new HttpError(500, `${path.basename(runner)} failed: ${log || error.message}`));
+      } else {
+        resolve();
+      }
+    });
+  });
+}
+
+// Runs one request in a scratch directory that is removed afterwards
+async function runBenchmark(run, upload, contentType) {
+  const dir = await mkdtemp(path.join(tmpdir(), "halide-serve-"));
+  try {
+    let input = findOriginal(run.op);
+    if (upload.length > 0) {
+      input = path.join(dir, `input${UPLOAD_EXTENSIONS[contentType] ?? ".png"}`);
+      await writeFile(input, upload);
+    }
+    const output = path.join(dir, "output.png");
+    const statsPath = path.join(dir, "stats.json");
+    await execRunner(runnerPath(run.op, run.variant), [
+      input,
+      output,
+      ...run.args,
+      "--warmup",
+      String(run.warmup),
+      "--iterations",
+      String(run.iterations),
+      "--stats",
+      statsPath,
+    ]);
+    const stats = JSON.parse(await readFile(statsPath, "utf8"));
+    const image = `data:image/png;base64,${(await readFile(output)).toString("base64")}`;
+    return { stats, image };
+  } finally {
+    await rm(dir, { recursive: true, force: true });
+  }
+}
+
+// One benchmark at a time: each request waits for the previous one to finish
+let queue = Promise.resolve();
+function enqueue(task) {
+  const result = queue.then(task);
+  queue = result.catch(() => {});
+  return result;
+}
+
+// Refuses requests from anywhere but this machine's dev server: a foreign Host means DNS
+// rebinding, a foreign Origin another site posting from the user's browser
+function checkCaller(request, origins) {
+  let hostname = "";
+  try {
+    hostname = new URL(`http://${request.headers.host ?? ""}`).hostname;
+  } catch {
+    // Unparsable Host: refused below
+  }
+  if (!LOCAL_HOSTS.has(hostname)) {
+    throw new HttpError(403, `Host ${request.headers.host ?? "(none)"} is not local`);
+  }
+  const origin = request.headers.origin;
+  if (origin !== undefined && !origins.has(origin)) {
+    throw new HttpError(403, `Origin ${origin} is not the dev server`);
+  }
+}
+
+async function handle(request, response, origins) {
+  checkCaller(request, origins);
+  const url = new URL(request.url, "http://localhost");
+  if (request.method === "GET" && url.pathname === "/api/halide/operators") {
+    const operators = OPERATORS.filter((op) => existsSync(runnerPath(op))).map((op) => ({
+      op,
+      variants: builtVariants(op),
+    }));
+    sendJson(response, 200, operators);
+  } else if (request.method === "POST" && url.pathname === "/api/halide/run") {
+    const run = parseRunRequest(url.searchParams);
+    const upload = await readBody(request);
+    const contentType = (request.headers["content-type"] ?? "").split(";")[0].trim();
+    const result = await enqueue(() => runBenchmark(run, upload, contentType));
+    console.log(
+      `${run.op}${run.variant ? "." + run.variant : ""}${run.args.length ? " " + run.args.join(" ") : ""}: ` +
+        `median ${result.stats.median_ms.toFixed(2)} ms (${result.stats.width}x${result.stats.height}` +
+        `${upload.length > 0 ? ", uploaded" : ""})`
+    );
+    sendJson(response, 200, result);
+  } else {
+    throw new HttpError(404, `No route for ${request.method} ${url.pathname}`);
+  }
+}
+
+const { port, origins } = parseArgs(process.argv.slice(2));
+createServer((request, response) => {
+  handle(request, response, origins).catch((error) => {
+    const status = error instanceof HttpError ? error.status : 500;
+    if (status === 500) {
+      console.error(error.message);
+    }
+    sendJson(response, status, { error: error.message });
+  });
+}).listen(port, "127.0.0.1", () => {
+  console.log(`Halide benchmark service on http://127.0.0.1:${port}/api/halide`);
+});
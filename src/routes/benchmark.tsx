@@ -2,6 +2,15 @@ import { createFileRoute } from "@tanstack/react-router";
 import { useState, useEffect } from "react";
 import { Card, CardContent, CardHeader, CardTitle } from "@/components/ui/card";
 import { Button } from "@/components/ui/button";
+import { Input } from "@/components/ui/input";
+import {
+  Table,
+  TableBody,
+  TableCell,
+  TableHead,
+  TableHeader,
+  TableRow,
+} from "@/components/ui/table";
 import Editor from "@monaco-editor/react";
 import { registerImageDslLanguage } from "@/lib/monacoDslLanguage";
 
@@ -9,6 +18,407 @@ export const Route = createFileRoute("/benchmark")({
   component: Benchmark,
 });
 
+// Written by the runners' --stats flag and merged into result.json by scripts/bench-halide.mjs
+interface HalideStats {
+  isa?: string;
+  threads?: number;
+  width: number;
+  height: number;
+  warmup: number;
+  iterations: number;
+  min_ms: number;
+  median_ms: number;
+  p95_ms: number;
+  mean_ms: number;
+  mpix_per_s: number;
+  decode_ms: number;
+  encode_ms: number;
+  // Halide heap through the runner's arena; counts cover the timed runs
+  arena_peak_bytes?: number;
+  arena_reserved_bytes?: number;
+  arena_allocations?: number;
+  arena_system_allocations?: number;
+  // Present when the run was checked against a reference image
+  mismatch?: number;
+  psnr?: number;
+}
+
+// Per-variant timings from the benchmark driver; group names the axis being varied
+interface HalideVariant extends HalideStats {
+  group: string;
+  name: string;
+  failed?: boolean;
+  // Packed-batch variants time many thumbnails per run
+  images_per_s?: number;
+}
+
+// Thread-scaling sweep from the driver's --scaling flag
+interface HalideScalingPoint {
+  threads: number;
+  width: number;
+  height: number;
+  median_ms: number;
+  mpix_per_s: number;
+  speedup: number;
+  efficiency: number;
+}
+
+interface HalideScalingCurve {
+  size: string;
+  points: HalideScalingPoint[];
+}
+
+interface HalideScaling {
+  cores: number;
+  threads: number[];
+  strong: HalideScalingCurve[];
+  weak: HalideScalingCurve;
+}
+
+// Written by the profiler runner's --profile flag, copied to profile.json by the driver
+interface HalideProfileStage {
+  name: string;
+  ms: number;
+  percent?: number;
+  memory_peak?: number;
+  threads?: number;
+}
+
+interface HalideProfile {
+  runs: number;
+  total_ms: number;
+  threads: number;
+  memory_peak: number;
+  stages: HalideProfileStage[];
+  host: HalideProfileStage[];
+}
+
+function formatBytes(value: number) {
+  if (value >= 1024 * 1024) {
+    return `${(value / (1024 * 1024)).toFixed(1)} MiB`;
+  }
+  return `${(value / 1024).toFixed(1)} KiB`;
+}
+
+function formatMs(value: number) {
+  return `${value.toFixed(2)} ms`;
+}
+
+// One-row summary of a runner's --stats output; codec adds the decode and encode times
+function HalideStatsTable({
+  stats,
+  codec = false,
+}: {
+  stats: HalideStats;
+  codec?: boolean;
+}) {
+  return (
+    <Table>
+      <TableHeader>
+        <TableRow>
+          <TableHead>Image</TableHead>
+          <TableHead>CPU</TableHead>
+          <TableHead>Threads</TableHead>
+          <TableHead>Runs</TableHead>
+          <TableHead>Min</TableHead>
+          <TableHead>Median</TableHead>
+          <TableHead>p95</TableHead>
+          <TableHead>Throughput</TableHead>
+          {codec && (
+            <>
+              <TableHead>Decode</TableHead>
+              <TableHead>Encode</TableHead>
+            </>
+          )}
+          <TableHead>Heap Peak</TableHead>
+        </TableRow>
+      </TableHeader>
+      <TableBody>
+        <TableRow>
+          <TableCell>
+            {stats.width}×{stats.height}
+          </TableCell>
+          <TableCell>{stats.isa ?? "--"}</TableCell>
+          <TableCell>{stats.threads ?? "--"}</TableCell>
+          <TableCell>
+            {stats.iterations} (+{stats.warmup} warm-up)
+          </TableCell>
+          <TableCell>{formatMs(stats.min_ms)}</TableCell>
+          <TableCell>{formatMs(stats.median_ms)}</TableCell>
+          <TableCell>{formatMs(stats.p95_ms)}</TableCell>
+          <TableCell>{stats.mpix_per_s.toFixed(1)} MP/s</TableCell>
+          {codec && (
+            <>
+              <TableCell>{formatMs(stats.decode_ms)}</TableCell>
+              <TableCell>{formatMs(stats.encode_ms)}</TableCell>
+            </>
+          )}
+          <TableCell>
+            {stats.arena_peak_bytes === undefined
+              ? "--"
+              : stats.arena_allocations === undefined
+                ? formatBytes(stats.arena_peak_bytes)
+                : `${formatBytes(stats.arena_peak_bytes)} (${
+                    stats.arena_system_allocations
+                  } of ${stats.arena_allocations} allocs new)`}
+          </TableCell>
+        </TableRow>
+      </TableBody>
+    </Table>
+  );
+}
+
+const SCALING_COLORS = ["#2563eb", "#16a34a", "#d97706", "#dc2626", "#7c3aed"];
+
+// Speedup against threads on log2 axes; the dashed diagonal is linear scaling
+function ScalingChart({ scaling }: { scaling: HalideScaling }) {
+  const width = 640;
+  const height = 320;
+  const pad = 44;
+  const maxThreads = scaling.threads[scaling.threads.length - 1];
+  const curves = [
+    ...scaling.strong.map((curve) => ({
+      label: `strong ${curve.size}`,
+      dashed: false,
+      ...curve,
+    })),
+    { label: `weak from ${scaling.weak.size}`, dashed: true, ...scaling.weak },
+  ];
+  const maxLog = Math.max(Math.log2(maxThreads), 1);
+  const x = (threads: number) =>
+    pad + (Math.log2(threads) / maxLog) * (width - 2 * pad);
+  const y = (speedup: number) =>
+    height -
+    pad -
+    (Math.log2(Math.max(speedup, 1)) / maxLog) * (height - 2 * pad);
+
+  return (
+    <div>
+      <svg viewBox={`0 0 ${width} ${height}`} className="w-full max-w-3xl">
+        <line
+          x1={pad}
+          y1={height - pad}
+          x2={width - pad}
+          y2={height - pad}
+          stroke="currentColor"
+        />
+        <line x1={pad} y1={pad} x2={pad} y2={height - pad} stroke="currentColor" />
+        {scaling.threads.map((threads) => (
+          <g key={threads} className="text-xs" fill="currentColor">
+            <text x={x(threads)} y={height - pad + 16} textAnchor="middle">
+              {threads}
+            </text>
+            <text x={pad - 6} y={y(threads) + 4} textAnchor="end">
+              {threads}×
+            </text>
+          </g>
+        ))}
+        <text
+          x={width / 2}
+          y={height - 6}
+          textAnchor="middle"
+          fill="currentColor"
+          className="text-xs"
+        >
+          threads
+        </text>
+        <line
+          x1={x(1)}
+          y1={y(1)}
+          x2={x(maxThreads)}
+          y2={y(maxThreads)}
+          stroke="currentColor"
+          strokeDasharray="4 4"
+          opacity={0.4}
+        />
+        {curves.map((curve, i) => (
+          <polyline
+            key={curve.label}
+            fill="none"
+            stroke={SCALING_COLORS[i % SCALING_COLORS.length]}
+            strokeWidth={2}
+            strokeDasharray={curve.dashed ? "6 3" : undefined}
+            points={curve.points
+              .map((point) => `${x(point.threads)},${y(point.speedup)}`)
+              .join(" ")}
+          />
+        ))}
+      </svg>
+      <div className="flex flex-wrap gap-4 text-sm mt-2">
+        {curves.map((curve, i) => {
+          const last = curve.points[curve.points.length - 1];
+          return (
+            <span key={curve.label} className="flex items-center gap-1">
+              <span
+                className="inline-block w-3 h-3 rounded-sm"
+                style={{
+                  background: SCALING_COLORS[i % SCALING_COLORS.length],
+                }}
+              />
+              {curve.label}: {last.speedup.toFixed(1)}× on {last.threads}{" "}
+              threads ({(last.efficiency * 100).toFixed(0)}% efficiency)
+            </span>
+          );
+        })}
+      </div>
+    </div>
+  );
+}
+
+// Served by scripts/serve-halide.mjs; absent unless the service is running
+interface LiveOperator {
+  op: string;
+  variants: string[];
+}
+
+interface LiveResult {
+  stats: HalideStats;
+  image: string;
+}
+
+// Times the built runner on this machine through the local benchmark service,
+// on the example's original or an uploaded image
+function LiveRun({ operator }: { operator: string }) {
+  const [available, setAvailable] = useState<LiveOperator[] | null>(null);
+  const [variant, setVariant] = useState("");
+  const [iterations, setIterations] = useState("30");
+  const [args, setArgs] = useState("");
+  const [upload, setUpload] = useState<File | null>(null);
+  const [running, setRunning] = useState(false);
+  const [error, setError] = useState<string | null>(null);
+  const [result, setResult] = useState<LiveResult | null>(null);
+
+  useEffect(() => {
+    fetch("/api/halide/operators")
+      .then((response) => (response.ok ? response.json() : null))
+      .then(setAvailable)
+      .catch(() => setAvailable(null));
+  }, []);
+
+  useEffect(() => {
+    setVariant("");
+    setArgs("");
+    setResult(null);
+    setError(null);
+  }, [operator]);
+
+  const live = available?.find((entry) => entry.op === operator);
+  if (!live) {
+    return (
+      <p className="text-sm text-muted-foreground">
+        {available
+          ? "No Halide runner is built for this operator; run npm run halide:build."
+          : "Start the local benchmark service (npm run halide:serve) to time the Halide runner on this machine."}
+      </p>
+    );
+  }
+
+  const run = async () => {
+    setRunning(true);
+    setError(null);
+    try {
+      const query = new URLSearchParams({ op: operator, iterations });
+      if (variant) {
+        query.set("variant", variant);
+      }
+      if (args.trim()) {
+        query.set("args", args.trim());
+      }
+      const response = await fetch(`/api/halide/run?${query}`, {
+        method: "POST",
+        headers: upload ? { "Content-Type": upload.type } : undefined,
+        body: upload ?? undefined,
+      });
+      // Errors from the dev server's proxy (e.g. 502 when the service is down) are not JSON
+      if (!response.headers.get("content-type")?.includes("application/json")) {
+        throw new Error(
+          response.status === 502
+            ? "The local benchmark service is not reachable; start it with npm run halide:serve."
+            : `Unexpected response: ${response.status} ${response.statusText}`
+        );
+      }
+      const body = await response.json();
+      if (!response.ok) {
+        throw new Error(body.error ?? response.statusText);
+      }
+      setResult(body);
+    } catch (runError) {
+      setError(runError instanceof Error ? runError.message : String(runError));
+    } finally {
+      setRunning(false);
+    }
+  };
+
+  return (
+    <div className="space-y-4">
+      <div className="flex flex-wrap items-end gap-3">
+        <label className="text-sm">
+          Variant
+          <select
+            className="block h-9 rounded-md border bg-transparent px-2"
+            value={variant}
+            onChange={(event) => setVariant(event.target.value)}
+          >
+            <option value="">default</option>
+            {live.variants.map((name) => (
+              <option key={name} value={name}>
+                {name}
+              </option>
+            ))}
+          </select>
+        </label>
+        <label className="text-sm">
+          Iterations
+          <Input
+            className="w-24"
+            type="number"
+            min={1}
+            max={1000}
+            value={iterations}
+            onChange={(event) => setIterations(event.target.value)}
+          />
+        </label>
+        <label className="text-sm">
+          Arguments
+          <Input
+            className="w-40"
+            placeholder="runner defaults"
+            value={args}
+            onChange={(event) => setArgs(event.target.value)}
+          />
+        </label>
+        <label className="text-sm">
+          Image
+          <Input
+            className="w-64"
+            type="file"
+            accept="image/png,image/jpeg,image/bmp,.ppm"
+            onChange={(event) => setUpload(event.target.files?.[0] ?? null)}
+          />
+        </label>
+        <Button onClick={run} disabled={running}>
+          {running ? "Running…" : "Run"}
+        </Button>
+      </div>
+      {error && (
+        <p className="text-sm text-red-600 whitespace-pre-wrap">{error}</p>
+      )}
+      {result && (
+        <>
+          <HalideStatsTable stats={result.stats} />
+          <div className="w-full flex items-center justify-center overflow-hidden border rounded-md">
+            <img
+              src={result.image}
+              alt="Live output"
+              className="max-w-full max-h-[600px] object-contain"
+            />
+          </div>
+        </>
+      )}
+    </div>
+  );
+}
+
 function SmartImage({
   basePath,
   filename,
@@ -74,6 +484,14 @@ function Benchmark() {
   const [halideCode, setHalideCode] = useState<string>("");
   const [dslTime, setDslTime] = useState<string>("-- ms");
   const [halideTime, setHalideTime] = useState<string>("-- ms");
+  const [halideStats, setHalideStats] = useState<HalideStats | null>(null);
+  const [halideVariants, setHalideVariants] = useState<HalideVariant[]>([]);
+  const [halideProfile, setHalideProfile] = useState<HalideProfile | null>(
+    null
+  );
+  const [halideScaling, setHalideScaling] = useState<HalideScaling | null>(
+    null
+  );
 
   useEffect(() => {
     const loadBenchmarkData = async () => {
@@ -102,24 +520,50 @@ function Benchmark() {
         );
         if (resultResponse.ok) {
           const resultData = await resultResponse.json();
-          setDslTime(resultData.dsl + " ms");
+          setDslTime((resultData.dsl ?? "--") + " ms");
           setHalideTime(resultData.halide + " ms");
+          setHalideStats(resultData.halide_stats ?? null);
+          setHalideVariants(resultData.halide_variants ?? []);
+          setHalideScaling(resultData.halide_scaling ?? null);
         } else {
           setDslTime("-- ms");
           setHalideTime("-- ms");
+          setHalideStats(null);
+          setHalideVariants([]);
+          setHalideScaling(null);
         }
+
+        // Load the per-stage profile, if the profiler build has been run
+        const profileResponse = await fetch(
+          `/examples/${selectedOperator}/profile.json`
+        );
+        setHalideProfile(
+          profileResponse.ok
+            ? await profileResponse.json().catch(() => null)
+            : null
+        );
       } catch (error) {
         console.error("Failed to load benchmark data:", error);
         setDslCode("// Error loading DSL code.");
         setHalideCode("// Error loading Halide code.");
         setDslTime("-- ms");
         setHalideTime("-- ms");
+        setHalideStats(null);
+        setHalideVariants([]);
+        setHalideProfile(null);
+        setHalideScaling(null);
       }
     };
 
     loadBenchmarkData();
   }, [selectedOperator]);
 
+  // Share of each stage, host stages included, relative to pipeline + host time
+  const profileTotalMs = halideProfile
+    ? halideProfile.total_ms +
+      halideProfile.host.reduce((sum, stage) => sum + stage.ms, 0)
+    : 0;
+
   const operators = [
     { id: "grayscale", name: "Grayscale", available: true },
     { id: "brightness", name: "Brightness", available: true },
@@ -129,7 +573,7 @@ function Benchmark() {
     { id: "canny", name: "Canny Edge Detection", available: true },
     { id: "harris", name: "Harris Corner Detection", available: false },
     { id: "unsharpmask", name: "Unsharp Mask", available: false },
-    { id: "bilateral", name: "Bilateral Filter", available: false },
+    { id: "bilateral", name: "Bilateral Filter", available: true },
     { id: "custom", name: "Custom Pipeline", available: false },
   ];
 
@@ -210,7 +654,156 @@ function Benchmark() {
         </CardContent>
       </Card>
 
-      {/* Row 3: Original image at 80% scale */}
+      {/* Row 3: Halide timing statistics, when the benchmark driver has run */}
+      {halideStats && (
+        <Card>
+          <CardHeader>
+            <CardTitle>Halide Timing</CardTitle>
+          </CardHeader>
+          <CardContent className="p-4">
+            <HalideStatsTable stats={halideStats} codec />
+            {halideVariants.length > 0 && (
+              <Table className="mt-6">
+                <TableHeader>
+                  <TableRow>
+                    <TableHead>Variant</TableHead>
+                    <TableHead>Median</TableHead>
+                    <TableHead>p95</TableHead>
+                    <TableHead>Throughput</TableHead>
+                    <TableHead>Speedup</TableHead>
+                    <TableHead>vs. Reference</TableHead>
+                  </TableRow>
+                </TableHeader>
+                <TableBody>
+                  {halideVariants.map((variant) => {
+                    // Speedup relative to the first variant of the same group;
+                    // algorithm and output variants are compared with the default pipeline
+                    const baseline =
+                      variant.group === "algorithm" || variant.group === "output"
+                        ? halideStats
+                        : halideVariants.find((v) => v.group === variant.group)!;
+                    return (
+                      <TableRow key={`${variant.group}-${variant.name}`}>
+                        <TableCell>
+                          {variant.group}: {variant.name}
+                        </TableCell>
+                        <TableCell>{formatMs(variant.median_ms)}</TableCell>
+                        <TableCell>{formatMs(variant.p95_ms)}</TableCell>
+                        <TableCell>
+                          {variant.images_per_s !== undefined
+                            ? `${variant.images_per_s.toFixed(0)} img/s`
+                            : `${variant.mpix_per_s.toFixed(1)} MP/s`}
+                        </TableCell>
+                        <TableCell>
+                          {(baseline.median_ms / variant.median_ms).toFixed(2)}×
+                        </TableCell>
+                        <TableCell>
+                          {variant.mismatch !== undefined && variant.psnr !== undefined
+                            ? `${(variant.mismatch * 100).toFixed(2)}% differ, ${variant.psnr.toFixed(1)} dB` +
+                              (variant.failed ? " (failed)" : "")
+                            : "—"}
+                        </TableCell>
+                      </TableRow>
+                    );
+                  })}
+                </TableBody>
+              </Table>
+            )}
+          </CardContent>
+        </Card>
+      )}
+
+      {/* Live run on this machine through scripts/serve-halide.mjs */}
+      <Card>
+        <CardHeader>
+          <CardTitle>Halide Live Run</CardTitle>
+        </CardHeader>
+        <CardContent className="p-4">
+          <LiveRun operator={selectedOperator} />
+        </CardContent>
+      </Card>
+
+      {/* Row 4: Speedup against threads, when the driver ran with --scaling */}
+      {halideScaling && (
+        <Card>
+          <CardHeader>
+            <CardTitle>
+              Halide Thread Scaling ({halideScaling.cores} cores)
+            </CardTitle>
+          </CardHeader>
+          <CardContent className="p-4">
+            <ScalingChart scaling={halideScaling} />
+          </CardContent>
+        </Card>
+      )}
+
+      {/* Row 5: Per-stage breakdown from Halide's profiler */}
+      {halideProfile && (
+        <Card>
+          <CardHeader>
+            <CardTitle>
+              Halide Stages ({formatMs(halideProfile.total_ms)} per run,{" "}
+              {halideProfile.threads.toFixed(1)} threads,{" "}
+              {formatBytes(halideProfile.memory_peak)} peak)
+            </CardTitle>
+          </CardHeader>
+          <CardContent className="p-4">
+            <Table>
+              <TableHeader>
+                <TableRow>
+                  <TableHead>Stage</TableHead>
+                  <TableHead>Time</TableHead>
+                  <TableHead className="w-1/3">Share</TableHead>
+                  <TableHead>Peak Memory</TableHead>
+                  <TableHead>Threads</TableHead>
+                </TableRow>
+              </TableHeader>
+              <TableBody>
+                {[
+                  ...halideProfile.stages,
+                  ...halideProfile.host.map((stage) => ({
+                    ...stage,
+                    name: `${stage.name} (host)`,
+                  })),
+                ].map((stage) => {
+                  const percent = (stage.ms / profileTotalMs) * 100;
+                  return (
+                    <TableRow key={stage.name}>
+                      <TableCell>{stage.name}</TableCell>
+                      <TableCell>{formatMs(stage.ms)}</TableCell>
+                      <TableCell>
+                        <div className="flex items-center gap-2">
+                          <div className="h-2 flex-grow rounded bg-muted">
+                            <div
+                              className="h-2 rounded bg-primary"
+                              style={{ width: `${percent}%` }}
+                            />
+                          </div>
+                          <span className="w-12 text-right">
+                            {percent.toFixed(1)}%
+                          </span>
+                        </div>
+                      </TableCell>
+                      <TableCell>
+                        {stage.memory_peak
+                          ? formatBytes(stage.memory_peak)
+                          : "—"}
+                      </TableCell>
+                      <TableCell>
+                        {stage.threads !== undefined
+                          ? stage.threads.toFixed(1)
+                          : "—"}
+                      </TableCell>
+                    </TableRow>
+                  );
+                })}
+              </TableBody>
+            </Table>
+          </CardContent>
+        </Card>
+      )}
+
+      {/* Row 6: Original image at 80% scale */}
       <Card>
         <CardHeader>
           <CardTitle>Original Image</CardTitle>
@@ -228,7 +821,7 @@ function Benchmark() {
         </CardContent>
       </Card>
 
-      {/* Row 4: Processed result at 80% scale */}
+      {/* Row 7: Processed result at 80% scale */}
       <Card>
         <CardHeader>
           <CardTitle>Processed Result</CardTitle>
@@ -19,4 +19,10 @@ export default defineConfig({
       "@": path.resolve(__dirname, "./src"),
     },
   },
+  server: {
+    proxy: {
+      // Live Halide runs on the benchmark page (scripts/serve-halide.mjs)
+      "/api/halide": "http://127.0.0.1:8787",
+    },
+  },
 });